@@ -1,41 +1,42 @@
 #include "ShaderProgram.h"
 
-ShaderProgram::ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders)
+ShaderProgram::ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders,
+                             const std::string &defines)
 {
 
   shaderProgram = glCreateProgram();
 
   if (inputShaders.find(GL_VERTEX_SHADER) != inputShaders.end())
   {
-    shaderObjects[GL_VERTEX_SHADER] = LoadShaderObject(GL_VERTEX_SHADER, inputShaders.at(GL_VERTEX_SHADER));
+    shaderObjects[GL_VERTEX_SHADER] = LoadShaderObject(GL_VERTEX_SHADER, inputShaders.at(GL_VERTEX_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_VERTEX_SHADER]);
   }
 
   if (inputShaders.find(GL_FRAGMENT_SHADER) != inputShaders.end())
   {
-    shaderObjects[GL_FRAGMENT_SHADER] = LoadShaderObject(GL_FRAGMENT_SHADER, inputShaders.at(GL_FRAGMENT_SHADER));
+    shaderObjects[GL_FRAGMENT_SHADER] = LoadShaderObject(GL_FRAGMENT_SHADER, inputShaders.at(GL_FRAGMENT_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_FRAGMENT_SHADER]);
   }
   if (inputShaders.find(GL_GEOMETRY_SHADER) != inputShaders.end())
   {
-    shaderObjects[GL_GEOMETRY_SHADER] = LoadShaderObject(GL_GEOMETRY_SHADER, inputShaders.at(GL_GEOMETRY_SHADER));
+    shaderObjects[GL_GEOMETRY_SHADER] = LoadShaderObject(GL_GEOMETRY_SHADER, inputShaders.at(GL_GEOMETRY_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_GEOMETRY_SHADER]);
   }
   if (inputShaders.find(GL_TESS_CONTROL_SHADER) != inputShaders.end())
   {
     shaderObjects[GL_TESS_CONTROL_SHADER] = LoadShaderObject(GL_TESS_CONTROL_SHADER,
-      inputShaders.at(GL_TESS_CONTROL_SHADER));
+      inputShaders.at(GL_TESS_CONTROL_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_TESS_CONTROL_SHADER]);
   }
   if (inputShaders.find(GL_TESS_EVALUATION_SHADER) != inputShaders.end())
   {
     shaderObjects[GL_TESS_EVALUATION_SHADER] = LoadShaderObject(GL_TESS_EVALUATION_SHADER,
-      inputShaders.at(GL_TESS_EVALUATION_SHADER));
+      inputShaders.at(GL_TESS_EVALUATION_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_TESS_EVALUATION_SHADER]);
   }
   if (inputShaders.find(GL_COMPUTE_SHADER) != inputShaders.end())
   {
-    shaderObjects[GL_COMPUTE_SHADER] = LoadShaderObject(GL_COMPUTE_SHADER, inputShaders.at(GL_COMPUTE_SHADER));
+    shaderObjects[GL_COMPUTE_SHADER] = LoadShaderObject(GL_COMPUTE_SHADER, inputShaders.at(GL_COMPUTE_SHADER), defines);
     glAttachShader(shaderProgram, shaderObjects[GL_COMPUTE_SHADER]);
   }
 
@@ -51,8 +52,10 @@ ShaderProgram::ShaderProgram(const std::unordered_map<GLenum, std::string> &inpu
     glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
     std::cerr << "Shader program linking failed\n" << infoLog << std::endl;
     shaderProgram = 0;
+    return;
   }
 
+  ReflectUniforms();
 }
 
 
@@ -118,11 +121,78 @@ bool ShaderProgram::reLink()
     return false;
   }
 
+  ReflectUniforms();
   return true;
 }
 
+bool ShaderProgram::CaptureVaryings(const std::vector<const char *> &names)
+{
+  glTransformFeedbackVaryings(shaderProgram, names.size(), names.data(),
+                              GL_INTERLEAVED_ATTRIBS);
+
+  return reLink();
+}
+
+void ShaderProgram::ReflectUniforms()
+{
+  uniforms.clear();
+
+  GLint count = 0;
+  GLint maxNameLength = 0;
+  glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+  std::string name(maxNameLength, '\0');
+
+  for (GLint i = 0; i < count; i++)
+  {
+    GLsizei nameLength = 0;
+    GLint size;
+    GLenum type;
+    glGetActiveUniform(shaderProgram, i, maxNameLength, &nameLength,
+                       &size, &type, &name[0]);
+
+    std::string uniformName(name, 0, nameLength);
+    GLint location = glGetUniformLocation(shaderProgram, uniformName.c_str());
+
+    // Members of uniform blocks have no location.
+    if (location == -1)
+      continue;
+
+    // Arrays are reported as their first element.
+    std::string::size_type bracket = uniformName.find('[');
+    if (bracket != std::string::npos)
+      uniformName.erase(bracket);
+
+    Uniform uniform;
+    uniform.location = location;
+    uniform.type = type;
+    uniforms[uniformName] = uniform;
+  }
+}
+
+GLint ShaderProgram::FindUniform(const char *name,
+                                 bool (*accepts)(GLenum type)) const
+{
+  auto found = uniforms.find(name);
+  if (found == uniforms.end())
+  {
+    std::cerr << "Uniform  " << name << " not found" << std::endl;
+    return -1;
+  }
+
+  if (!accepts(found->second.type))
+  {
+    std::cerr << "Uniform  " << name << " has a different type" << std::endl;
+    return -1;
+  }
 
-GLuint ShaderProgram::LoadShaderObject(GLenum type, const std::string &filename)
+  return found->second.location;
+}
+
+
+GLuint ShaderProgram::LoadShaderObject(GLenum type, const std::string &filename,
+                                       const std::string &defines)
 {
   std::ifstream fs(filename);
 
@@ -134,6 +204,14 @@ GLuint ShaderProgram::LoadShaderObject(GLenum type, const std::string &filename)
 
   std::string shaderText((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
 
+  // #version has to stay first; #line keeps error messages pointing at
+  // the lines of the file.
+  if (!defines.empty())
+  {
+    size_t versionEnd = shaderText.find('\n') + 1;
+    shaderText.insert(versionEnd, defines + "#line 2\n");
+  }
+
   GLuint newShaderObject = glCreateShader(type);
 
   const char *shaderSrc = shaderText.c_str();
@@ -165,72 +243,13 @@ void ShaderProgram::StopUseShader() const
   glUseProgram(0);
 }
 
-void ShaderProgram::SetUniform(const std::string &location, int value) const
-{
-  GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
-  if (uniformLocation == -1)
-  {
-    std::cerr << "Uniform  " << location << " not found" << std::endl;
-    return;
-  }
-  glUniform1i(uniformLocation, value);
-}
-
-void ShaderProgram::SetUniform(const std::string &location, unsigned int value) const
-{
-  GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
-  if (uniformLocation == -1)
-  {
-    std::cerr << "Uniform  " << location << " not found" << std::endl;
-    return;
-  }
-  glUniform1ui(uniformLocation, value);
-}
-
-void ShaderProgram::SetUniform(const std::string &location, float value) const
-{
-  GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
-  if (uniformLocation == -1)
-  {
-    std::cerr << "Uniform  " << location << " not found" << std::endl;
-    return;
-  }
-  glUniform1f(uniformLocation, value);
-}
-
-void ShaderProgram::SetUniform(const std::string &location, double value) const
-{
-  GLint uniformLocation = glGetUniformLocation(shaderProgram, location.c_str());
-  if (uniformLocation == -1)
-  {
-    std::cerr << "Uniform  " << location << " not found" << std::endl;
-    return;
-  }
-  glUniform1d(uniformLocation, value);
-}
-
-void ShaderProgram::SetUniform(const std::string &location,
-                               const glm::vec3 &value) const
-{
-  GLint uniformLocation = glGetUniformLocation(shaderProgram,
-                                               location.c_str());
-  if (uniformLocation == -1)
-  {
-    std::cerr << "Uniform  " << location << " not found" << std::endl;
-    return;
-  }
-  glUniform3fv(uniformLocation, 1, &value[0]);
-}
-
-void ShaderProgram::SetUniform(const std::string &location,
-                               const glm::mat4 &mat) const
+void ShaderProgram::BindUniformBlock(const char *name, GLuint binding) const
 {
-  GLint uniformLocation = glGetUniformLocation(shaderProgram,
-                                               location.c_str());
-  if (uniformLocation == -1)
+  GLuint blockIndex = glGetUniformBlockIndex(shaderProgram, name);
+  if (blockIndex == GL_INVALID_INDEX)
   {
-    std::cerr << "Uniform  " << location << " not found" << std::endl;
+    std::cerr << "Uniform block " << name << " not found" << std::endl;
     return;
   }
-  glUniformMatrix4fv(uniformLocation, 1, GL_FALSE, &mat[0][0]);
+  glUniformBlockBinding(shaderProgram, blockIndex, binding);
 }
@@ -5,15 +5,86 @@
 #include "common.h"
 
 #include <unordered_map>
+#include <vector>
 
 
+// Which GLSL uniform types a value of type T can be set to.
+template <typename T>
+struct UniformTraits;
+
+template <>
+struct UniformTraits<float>
+{
+  static bool Accepts(GLenum type) { return type == GL_FLOAT; }
+};
+
+template <>
+struct UniformTraits<double>
+{
+  static bool Accepts(GLenum type) { return type == GL_DOUBLE; }
+};
+
+template <>
+struct UniformTraits<int>
+{
+  // Samplers are set to a texture unit.
+  static bool Accepts(GLenum type)
+  {
+    return type == GL_INT || type == GL_BOOL ||
+           type == GL_SAMPLER_1D || type == GL_SAMPLER_2D ||
+           type == GL_SAMPLER_3D || type == GL_SAMPLER_CUBE ||
+           type == GL_SAMPLER_2D_SHADOW || type == GL_SAMPLER_2D_ARRAY;
+  }
+};
+
+template <>
+struct UniformTraits<unsigned int>
+{
+  static bool Accepts(GLenum type) { return type == GL_UNSIGNED_INT; }
+};
+
+template <>
+struct UniformTraits<glm::vec3>
+{
+  static bool Accepts(GLenum type) { return type == GL_FLOAT_VEC3; }
+};
+
+template <>
+struct UniformTraits<glm::vec4>
+{
+  static bool Accepts(GLenum type) { return type == GL_FLOAT_VEC4; }
+};
+
+template <>
+struct UniformTraits<glm::mat4>
+{
+  static bool Accepts(GLenum type) { return type == GL_FLOAT_MAT4; }
+};
+
+// Location of a uniform that takes values of type T. The default one, like
+// any handle that failed to resolve, is -1, which glUniform* ignores.
+template <typename T>
+struct UniformHandle
+{
+  GLint location;
+
+  UniformHandle() : location(-1) {}
+
+  explicit UniformHandle(GLint a_location) : location(a_location) {}
+
+  bool IsValid() const { return location != -1; }
+};
+
 class ShaderProgram
 {
 public:
 
   ShaderProgram() : shaderProgram(-1) {};
 
-  ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders);
+  // defines, if given, are inserted into every stage right after its
+  // #version line, e.g. to size arrays from constants of the C++ side.
+  ShaderProgram(const std::unordered_map<GLenum, std::string> &inputShaders,
+                const std::string &defines = std::string());
 
   virtual ~ShaderProgram() {};
 
@@ -28,25 +99,87 @@ public:
 
   bool reLink();
 
-  void SetUniform(const std::string &location, float value) const;
-
-  void SetUniform(const std::string &location, double value) const;
+  // Records the vertex shader outputs called names, interleaved in that
+  // order, into the transform feedback buffer while feedback is active.
+  // Relinks the program.
+  bool CaptureVaryings(const std::vector<const char *> &names);
+
+  // Handle of the active uniform called name, looked up in the table
+  // built at link time. Reports once, here, if the program has no such
+  // uniform or its type doesn't take a T; setting such a handle does
+  // nothing. Handles must be resolved again after reLink().
+  template <typename T>
+  UniformHandle<T> GetUniform(const char *name) const
+  {
+    return UniformHandle<T>(FindUniform(name, UniformTraits<T>::Accepts));
+  }
+
+  // These set the uniform on the program in use.
+
+  void SetUniform(UniformHandle<float> uniform, float value) const
+  {
+    glUniform1f(uniform.location, value);
+  }
+
+  void SetUniform(UniformHandle<double> uniform, double value) const
+  {
+    glUniform1d(uniform.location, value);
+  }
+
+  void SetUniform(UniformHandle<int> uniform, int value) const
+  {
+    glUniform1i(uniform.location, value);
+  }
+
+  void SetUniform(UniformHandle<unsigned int> uniform,
+                  unsigned int value) const
+  {
+    glUniform1ui(uniform.location, value);
+  }
+
+  void SetUniform(UniformHandle<glm::vec3> uniform,
+                  const glm::vec3 &value) const
+  {
+    glUniform3fv(uniform.location, 1, &value[0]);
+  }
+
+  // Sets count elements of an array uniform from its first one on.
+  void SetUniform(UniformHandle<glm::vec4> uniform,
+                  const glm::vec4 *values,
+                  GLsizei count) const
+  {
+    glUniform4fv(uniform.location, count, &values[0][0]);
+  }
+
+  void SetUniform(UniformHandle<glm::mat4> uniform,
+                  const glm::mat4 &mat) const
+  {
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+  }
+
+  // Attaches the uniform block called name to a buffer binding point.
+  void BindUniformBlock(const char *name, GLuint binding) const;
 
-  void SetUniform(const std::string &location, int value) const;
-
-  void SetUniform(const std::string &location, unsigned int value) const;
+private:
+  struct Uniform
+  {
+    GLint location;
+    GLenum type;
+  };
 
-  void SetUniform(const std::string &location,
-                                 const glm::vec3 &value) const;
+  static GLuint LoadShaderObject(GLenum type, const std::string &filename,
+                                 const std::string &defines);
 
-  void SetUniform(const std::string &location,
-                                 const glm::mat4 &mat) const;
+  // Fills uniforms from the active uniforms of the linked program.
+  void ReflectUniforms();
 
-private:
-  static GLuint LoadShaderObject(GLenum type, const std::string &filename);
+  GLint FindUniform(const char *name, bool (*accepts)(GLenum type)) const;
 
   GLuint shaderProgram;
   std::unordered_map<GLenum, GLuint> shaderObjects;
+
+  // Active uniforms outside of uniform blocks, by name.
+  std::unordered_map<std::string, Uniform> uniforms;
 };
 
 
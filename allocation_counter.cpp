@@ -0,0 +1,82 @@
+#include "allocation_counter.h"
+
+#ifdef COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+static std::atomic<unsigned long> allocations {0};
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    void *ptr = std::malloc(size > 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+bool counting_allocations()
+{
+    return true;
+}
+
+unsigned long allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool counting_allocations()
+{
+    return false;
+}
+
+unsigned long allocation_count()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+
+// Heap allocation counting for checking that the frame loop doesn't
+// allocate. Configuring with -DCOUNT_ALLOCATIONS=ON replaces the global
+// operator new with one that counts every call; otherwise nothing is
+// hooked and the count stays at zero.
+
+// Whether this build counts allocations.
+bool counting_allocations();
+
+// Calls to the global operator new so far, from all threads.
+unsigned long allocation_count();
+
+
+#endif
@@ -0,0 +1,278 @@
+#include "collision.h"
+
+#if defined(__x86_64__) || defined(__i386__) || \
+        defined(_M_X64) || defined(_M_IX86)
+#define COLLISION_X86
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define COLLISION_TARGET_SSE2
+#define COLLISION_TARGET_AVX2
+#else
+#define COLLISION_TARGET_SSE2 __attribute__((target("sse2")))
+#define COLLISION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+static uint32_t swept_hits_scalar(const glm::vec3 &target0,
+                                  const glm::vec3 &target1,
+                                  float radius,
+                                  const float *x0,
+                                  const float *y0,
+                                  const float *z0,
+                                  const float *x1,
+                                  const float *y1,
+                                  const float *z1,
+                                  unsigned int count)
+{
+    uint32_t mask = 0;
+
+    for (unsigned int k = 0; k < count; k++) {
+        glm::vec3 p0 = glm::vec3(x0[k], y0[k], z0[k]) - target0;
+        glm::vec3 p1 = glm::vec3(x1[k], y1[k], z1[k]) - target1;
+
+        if (swept_point_hits_sphere(p0, p1, radius)) {
+            mask |= 1u << k;
+        }
+    }
+
+    return mask;
+}
+
+#ifdef COLLISION_X86
+
+// The vector kernels evaluate swept_point_hits_sphere() for every lane, in
+// the same operation order, and pick the result of the case that applies;
+// the scalar kernel handles the tail of the block.
+
+COLLISION_TARGET_SSE2
+static uint32_t swept_hits_sse2(const glm::vec3 &target0,
+                                const glm::vec3 &target1,
+                                float radius,
+                                const float *x0,
+                                const float *y0,
+                                const float *z0,
+                                const float *x1,
+                                const float *y1,
+                                const float *z1,
+                                unsigned int count)
+{
+    const __m128 t0x = _mm_set1_ps(target0.x);
+    const __m128 t0y = _mm_set1_ps(target0.y);
+    const __m128 t0z = _mm_set1_ps(target0.z);
+    const __m128 t1x = _mm_set1_ps(target1.x);
+    const __m128 t1y = _mm_set1_ps(target1.y);
+    const __m128 t1z = _mm_set1_ps(target1.z);
+    const __m128 r2 = _mm_set1_ps(radius * radius);
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t mask = 0;
+    unsigned int k = 0;
+
+    for (; k + 4 <= count; k += 4) {
+        __m128 p0x = _mm_sub_ps(_mm_loadu_ps(x0 + k), t0x);
+        __m128 p0y = _mm_sub_ps(_mm_loadu_ps(y0 + k), t0y);
+        __m128 p0z = _mm_sub_ps(_mm_loadu_ps(z0 + k), t0z);
+        __m128 p1x = _mm_sub_ps(_mm_loadu_ps(x1 + k), t1x);
+        __m128 p1y = _mm_sub_ps(_mm_loadu_ps(y1 + k), t1y);
+        __m128 p1z = _mm_sub_ps(_mm_loadu_ps(z1 + k), t1z);
+
+        __m128 dx = _mm_sub_ps(p1x, p0x);
+        __m128 dy = _mm_sub_ps(p1y, p0y);
+        __m128 dz = _mm_sub_ps(p1z, p0z);
+
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+                                            _mm_mul_ps(dy, dy)),
+                                 _mm_mul_ps(dz, dz));
+        __m128 proj = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0x, dx),
+                                            _mm_mul_ps(p0y, dy)),
+                                 _mm_mul_ps(p0z, dz));
+        __m128 dist0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0x, p0x),
+                                             _mm_mul_ps(p0y, p0y)),
+                                  _mm_mul_ps(p0z, p0z));
+        __m128 dist1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p1x, p1x),
+                                             _mm_mul_ps(p1y, p1y)),
+                                  _mm_mul_ps(p1z, p1z));
+
+        __m128 at_start = _mm_cmpge_ps(proj, zero);
+        __m128 at_end = _mm_cmpge_ps(_mm_sub_ps(zero, proj), len2);
+
+        __m128 hit_start = _mm_cmple_ps(dist0, r2);
+        __m128 hit_end = _mm_cmple_ps(dist1, r2);
+        __m128 hit_inside = _mm_cmple_ps(
+                _mm_sub_ps(_mm_mul_ps(dist0, len2), _mm_mul_ps(proj, proj)),
+                _mm_mul_ps(r2, len2));
+
+        __m128 hit = _mm_or_ps(_mm_and_ps(at_end, hit_end),
+                               _mm_andnot_ps(at_end, hit_inside));
+        hit = _mm_or_ps(_mm_and_ps(at_start, hit_start),
+                        _mm_andnot_ps(at_start, hit));
+
+        mask |= (uint32_t) _mm_movemask_ps(hit) << k;
+    }
+
+    if (k < count) {
+        mask |= swept_hits_scalar(target0, target1, radius,
+                                  x0 + k, y0 + k, z0 + k,
+                                  x1 + k, y1 + k, z1 + k,
+                                  count - k) << k;
+    }
+
+    return mask;
+}
+
+COLLISION_TARGET_AVX2
+static uint32_t swept_hits_avx2(const glm::vec3 &target0,
+                                const glm::vec3 &target1,
+                                float radius,
+                                const float *x0,
+                                const float *y0,
+                                const float *z0,
+                                const float *x1,
+                                const float *y1,
+                                const float *z1,
+                                unsigned int count)
+{
+    const __m256 t0x = _mm256_set1_ps(target0.x);
+    const __m256 t0y = _mm256_set1_ps(target0.y);
+    const __m256 t0z = _mm256_set1_ps(target0.z);
+    const __m256 t1x = _mm256_set1_ps(target1.x);
+    const __m256 t1y = _mm256_set1_ps(target1.y);
+    const __m256 t1z = _mm256_set1_ps(target1.z);
+    const __m256 r2 = _mm256_set1_ps(radius * radius);
+    const __m256 zero = _mm256_setzero_ps();
+
+    uint32_t mask = 0;
+    unsigned int k = 0;
+
+    for (; k + 8 <= count; k += 8) {
+        __m256 p0x = _mm256_sub_ps(_mm256_loadu_ps(x0 + k), t0x);
+        __m256 p0y = _mm256_sub_ps(_mm256_loadu_ps(y0 + k), t0y);
+        __m256 p0z = _mm256_sub_ps(_mm256_loadu_ps(z0 + k), t0z);
+        __m256 p1x = _mm256_sub_ps(_mm256_loadu_ps(x1 + k), t1x);
+        __m256 p1y = _mm256_sub_ps(_mm256_loadu_ps(y1 + k), t1y);
+        __m256 p1z = _mm256_sub_ps(_mm256_loadu_ps(z1 + k), t1z);
+
+        __m256 dx = _mm256_sub_ps(p1x, p0x);
+        __m256 dy = _mm256_sub_ps(p1y, p0y);
+        __m256 dz = _mm256_sub_ps(p1z, p0z);
+
+        __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx),
+                                                  _mm256_mul_ps(dy, dy)),
+                                    _mm256_mul_ps(dz, dz));
+        __m256 proj = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p0x, dx),
+                                                  _mm256_mul_ps(p0y, dy)),
+                                    _mm256_mul_ps(p0z, dz));
+        __m256 dist0 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p0x, p0x),
+                                                   _mm256_mul_ps(p0y, p0y)),
+                                     _mm256_mul_ps(p0z, p0z));
+        __m256 dist1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p1x, p1x),
+                                                   _mm256_mul_ps(p1y, p1y)),
+                                     _mm256_mul_ps(p1z, p1z));
+
+        __m256 at_start = _mm256_cmp_ps(proj, zero, _CMP_GE_OQ);
+        __m256 at_end = _mm256_cmp_ps(_mm256_sub_ps(zero, proj),
+                                      len2,
+                                      _CMP_GE_OQ);
+
+        __m256 hit_start = _mm256_cmp_ps(dist0, r2, _CMP_LE_OQ);
+        __m256 hit_end = _mm256_cmp_ps(dist1, r2, _CMP_LE_OQ);
+        __m256 hit_inside = _mm256_cmp_ps(
+                _mm256_sub_ps(_mm256_mul_ps(dist0, len2),
+                              _mm256_mul_ps(proj, proj)),
+                _mm256_mul_ps(r2, len2),
+                _CMP_LE_OQ);
+
+        __m256 hit = _mm256_blendv_ps(hit_inside, hit_end, at_end);
+        hit = _mm256_blendv_ps(hit, hit_start, at_start);
+
+        mask |= (uint32_t) _mm256_movemask_ps(hit) << k;
+    }
+
+    if (k < count) {
+        mask |= swept_hits_sse2(target0, target1, radius,
+                                x0 + k, y0 + k, z0 + k,
+                                x1 + k, y1 + k, z1 + k,
+                                count - k) << k;
+    }
+
+    return mask;
+}
+
+static bool cpu_has_avx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 1);
+    bool os_saves_ymm = (info[2] & (1 << 27)) and
+                        (_xgetbv(0) & 6) == 6;
+
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm and (info[1] & (1 << 5));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+CollisionIsa best_collision_isa()
+{
+#ifdef COLLISION_X86
+    static const CollisionIsa isa = cpu_has_avx2() ? COLLISION_AVX2 :
+                                                     COLLISION_SSE2;
+    return isa;
+#else
+    return COLLISION_SCALAR;
+#endif
+}
+
+const char *collision_isa_name(CollisionIsa isa)
+{
+    switch (isa) {
+    case COLLISION_SCALAR:
+        return "scalar";
+
+    case COLLISION_SSE2:
+        return "SSE2";
+
+    case COLLISION_AVX2:
+        return "AVX2";
+    }
+
+    return "unknown";
+}
+
+SweptHitKernel swept_hit_kernel(CollisionIsa isa)
+{
+    if (isa > best_collision_isa()) {
+        return nullptr;
+    }
+
+    switch (isa) {
+    case COLLISION_SCALAR:
+        return swept_hits_scalar;
+
+#ifdef COLLISION_X86
+    case COLLISION_SSE2:
+        return swept_hits_sse2;
+
+    case COLLISION_AVX2:
+        return swept_hits_avx2;
+#else
+    default:
+        break;
+#endif
+    }
+
+    return nullptr;
+}
+
+SweptHitKernel swept_hit_kernel()
+{
+    return swept_hit_kernel(best_collision_isa());
+}
@@ -0,0 +1,81 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+
+// Continuous hit test between a moving point and a moving sphere.
+//
+// Both move linearly over the tick, so in the sphere's frame the point
+// travels from p0 to p1, the differences between the point and the sphere
+// centre at the start and at the end of the tick. The point hits if the
+// closest point of that segment lies within radius of the origin. Unlike a
+// test at the end positions only, this cannot miss a fast projectile that
+// passes through the sphere between two ticks.
+//
+// Everything is compared squared and the projection onto the segment is
+// kept unnormalised, so there is no sqrt and no division.
+inline bool swept_point_hits_sphere(const glm::vec3 &p0,
+                                    const glm::vec3 &p1,
+                                    float radius)
+{
+    glm::vec3 d = p1 - p0;
+    float len2 = glm::dot(d, d);
+    float proj = glm::dot(p0, d);
+    float r2 = radius * radius;
+
+    // Closest to the start point.
+    if (proj >= 0.0f) {
+        return glm::dot(p0, p0) <= r2;
+    }
+
+    // Closest to the end point.
+    if (-proj >= len2) {
+        return glm::dot(p1, p1) <= r2;
+    }
+
+    // Closest inside the segment: |p0|^2 - proj^2 / len2 <= r^2.
+    return glm::dot(p0, p0) * len2 - proj * proj <= r2 * len2;
+}
+
+// Projectiles per kernel call, one bit each in the returned mask.
+#define COLLISION_BLOCK 32
+
+enum CollisionIsa
+{
+    COLLISION_SCALAR,
+    COLLISION_SSE2,
+    COLLISION_AVX2
+};
+
+// Tests one target sphere, moving from target0 to target1 over the tick,
+// against a packed block of count <= COLLISION_BLOCK projectiles given as
+// start (x0, y0, z0) and end (x1, y1, z1) coordinate arrays. Bit k of the
+// result is set if projectile k hits.
+typedef uint32_t (*SweptHitKernel)(const glm::vec3 &target0,
+                                   const glm::vec3 &target1,
+                                   float radius,
+                                   const float *x0,
+                                   const float *y0,
+                                   const float *z0,
+                                   const float *x1,
+                                   const float *y1,
+                                   const float *z1,
+                                   unsigned int count);
+
+// Widest instruction set the running CPU supports, detected once.
+CollisionIsa best_collision_isa();
+
+const char *collision_isa_name(CollisionIsa isa);
+
+// Kernel for the given instruction set, or nullptr if this build or CPU
+// can't run it.
+SweptHitKernel swept_hit_kernel(CollisionIsa isa);
+
+// Kernel for best_collision_isa().
+SweptHitKernel swept_hit_kernel();
+
+
+#endif
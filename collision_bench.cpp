@@ -0,0 +1,263 @@
+#include "collision.h"
+#include "simulation.h"
+#include "spatial_hash.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+
+// Projectile-vs-target collision cost as a function of entity count:
+// the old all-pairs scan against the spatial hash broadphase (including its
+// per-tick rebuild). Both must report the same number of hits.
+//
+// The second table times the swept narrow phase alone: one target against
+// contiguous blocks of projectiles, per pair through
+// swept_point_hits_sphere() and through each kernel this CPU can run.
+
+struct Points
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+};
+
+static Points random_points(unsigned int count, std::mt19937 &rng)
+{
+    // Roughly the volume ships, asteroids and player fire occupy in game.
+    std::uniform_real_distribution<float> xy(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> depth(-110.0f, 0.0f);
+
+    Points points;
+
+    for (unsigned int i = 0; i < count; i++) {
+        points.x.push_back(xy(rng));
+        points.y.push_back(xy(rng));
+        points.z.push_back(depth(rng));
+    }
+
+    return points;
+}
+
+static long brute_force(const Points &targets, const Points &balls)
+{
+    long hits = 0;
+
+    for (unsigned int i = 0; i < targets.x.size(); i++) {
+        glm::vec3 target(targets.x[i], targets.y[i], targets.z[i]);
+
+        for (unsigned int j = 0; j < balls.x.size(); j++) {
+            glm::vec3 ball(balls.x[j], balls.y[j], balls.z[j]);
+
+            if (glm::distance(target, ball) <= DIST) {
+                hits++;
+            }
+        }
+    }
+
+    return hits;
+}
+
+static long broadphase(SpatialHash &grid,
+                       const Points &targets,
+                       const Points &balls)
+{
+    long hits = 0;
+
+    grid.build(balls.x.data(), balls.y.data(), balls.z.data(), balls.x.size());
+
+    for (unsigned int i = 0; i < targets.x.size(); i++) {
+        glm::vec3 target(targets.x[i], targets.y[i], targets.z[i]);
+
+        grid.for_each_near(target, DIST, [&](unsigned int j) {
+            glm::vec3 ball(balls.x[j], balls.y[j], balls.z[j]);
+
+            if (glm::distance(target, ball) <= DIST) {
+                hits++;
+            }
+        });
+    }
+
+    return hits;
+}
+
+// Segments of roughly the length a player plasm ball covers in a 30 Hz tick.
+static Points displace(const Points &start, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> step(-5.0f, 5.0f);
+
+    Points end = start;
+
+    for (unsigned int i = 0; i < start.x.size(); i++) {
+        end.x[i] += step(rng);
+        end.y[i] += step(rng);
+        end.z[i] += step(rng);
+    }
+
+    return end;
+}
+
+static long swept_pairwise(const Points &targets,
+                           const Points &start,
+                           const Points &end)
+{
+    long hits = 0;
+
+    for (unsigned int i = 0; i < targets.x.size(); i++) {
+        glm::vec3 target(targets.x[i], targets.y[i], targets.z[i]);
+
+        for (unsigned int j = 0; j < start.x.size(); j++) {
+            glm::vec3 p0(start.x[j], start.y[j], start.z[j]);
+            glm::vec3 p1(end.x[j], end.y[j], end.z[j]);
+
+            if (swept_point_hits_sphere(p0 - target, p1 - target, DIST)) {
+                hits++;
+            }
+        }
+    }
+
+    return hits;
+}
+
+static long swept_blocks(SweptHitKernel kernel,
+                         const Points &targets,
+                         const Points &start,
+                         const Points &end)
+{
+    long hits = 0;
+    unsigned int n = start.x.size();
+
+    for (unsigned int i = 0; i < targets.x.size(); i++) {
+        glm::vec3 target(targets.x[i], targets.y[i], targets.z[i]);
+
+        for (unsigned int base = 0; base < n; base += COLLISION_BLOCK) {
+            unsigned int count = std::min(n - base,
+                                          (unsigned int) COLLISION_BLOCK);
+
+            uint32_t mask = kernel(target, target, DIST,
+                                   &start.x[base],
+                                   &start.y[base],
+                                   &start.z[base],
+                                   &end.x[base],
+                                   &end.y[base],
+                                   &end.z[base],
+                                   count);
+
+            for (; mask != 0; mask &= mask - 1) {
+                hits++;
+            }
+        }
+    }
+
+    return hits;
+}
+
+template <typename F>
+static double time_ms(F f, int repeats)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < repeats; r++) {
+        f();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() /
+           repeats;
+}
+
+int main()
+{
+    static const unsigned int counts[] = {10, 100, 1000, 10000};
+
+    std::mt19937 rng(0);
+    SpatialHash grid(BROADPHASE_CELL_SIZE);
+
+    std::printf("%8s %8s %12s %12s %8s %8s\n",
+                "targets", "balls", "brute ms", "hash ms", "speedup", "hits");
+
+    for (auto target_count: counts) {
+        for (auto ball_count: counts) {
+            Points targets = random_points(target_count, rng);
+            Points balls = random_points(ball_count, rng);
+
+            long pairs = (long) target_count * ball_count;
+            int repeats = pairs > 10000000 ? 1 : 20;
+
+            long brute_hits = 0;
+            long hash_hits = 0;
+
+            double brute_ms = time_ms([&]() {
+                brute_hits = brute_force(targets, balls);
+            }, repeats);
+
+            double hash_ms = time_ms([&]() {
+                hash_hits = broadphase(grid, targets, balls);
+            }, repeats);
+
+            std::printf("%8u %8u %12.3f %12.3f %7.1fx %8ld%s\n",
+                        target_count,
+                        ball_count,
+                        brute_ms,
+                        hash_ms,
+                        brute_ms / hash_ms,
+                        hash_hits,
+                        brute_hits == hash_hits ? "" : "  MISMATCH");
+        }
+    }
+
+    std::printf("\nSwept narrow phase, 1000 targets, best ISA: %s\n",
+                collision_isa_name(best_collision_isa()));
+
+    std::printf("%8s %12s %12s %12s %12s %8s\n",
+                "balls", "pairwise ms", "scalar ms", "SSE2 ms", "AVX2 ms",
+                "hits");
+
+    static const unsigned int ball_counts[] = {32, 1000, 10000};
+    static const CollisionIsa isas[] = {
+        COLLISION_SCALAR, COLLISION_SSE2, COLLISION_AVX2
+    };
+
+    Points targets = random_points(1000, rng);
+
+    for (auto ball_count: ball_counts) {
+        Points start = random_points(ball_count, rng);
+        Points end = displace(start, rng);
+
+        int repeats = ball_count > 1000 ? 3 : 30;
+
+        long pairwise_hits = 0;
+        double pairwise_ms = time_ms([&]() {
+            pairwise_hits = swept_pairwise(targets, start, end);
+        }, repeats);
+
+        std::printf("%8u %12.3f", ball_count, pairwise_ms);
+
+        bool mismatch = false;
+
+        for (auto isa: isas) {
+            SweptHitKernel kernel = swept_hit_kernel(isa);
+
+            if (kernel == nullptr) {
+                std::printf(" %12s", "n/a");
+                continue;
+            }
+
+            long hits = 0;
+            double ms = time_ms([&]() {
+                hits = swept_blocks(kernel, targets, start, end);
+            }, repeats);
+
+            mismatch = mismatch or hits != pairwise_hits;
+            std::printf(" %12.3f", ms);
+        }
+
+        std::printf(" %8ld%s\n", pairwise_hits, mismatch ? "  MISMATCH" : "");
+    }
+
+    return 0;
+}
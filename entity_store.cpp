@@ -0,0 +1,151 @@
+#include "entity_store.h"
+
+#include <algorithm>
+#include <functional>
+
+
+EntityStore::EntityStore(unsigned int capacity)
+{
+    reserve(capacity);
+}
+
+void EntityStore::reserve(unsigned int capacity)
+{
+    appearance_timestamp.reserve(capacity);
+    last_shot_timestamp.reserve(capacity);
+    coords_x.reserve(capacity);
+    coords_y.reserve(capacity);
+    coords_z.reserve(capacity);
+    real_x.reserve(capacity);
+    real_y.reserve(capacity);
+    real_z.reserve(capacity);
+    prev_x.reserve(capacity);
+    prev_y.reserve(capacity);
+    prev_z.reserve(capacity);
+    obj_type.reserve(capacity);
+    model.reserve(capacity);
+    handle_id.reserve(capacity);
+    removed.reserve(capacity);
+    removed_pos.reserve(capacity);
+    index_of_id.reserve(capacity);
+    generations.reserve(capacity);
+    free_ids.reserve(capacity);
+}
+
+unsigned int EntityStore::add(float timestamp,
+                              const glm::vec3 &coords,
+                              ObjTypes type,
+                              ModelHandle model_handle)
+{
+    appearance_timestamp.push_back(timestamp);
+    last_shot_timestamp.push_back(timestamp);
+    coords_x.push_back(coords.x);
+    coords_y.push_back(coords.y);
+    coords_z.push_back(coords.z);
+    real_x.push_back(coords.x);
+    real_y.push_back(coords.y);
+    real_z.push_back(coords.z);
+    prev_x.push_back(coords.x);
+    prev_y.push_back(coords.y);
+    prev_z.push_back(coords.z);
+    obj_type.push_back(type);
+    model.push_back(model_handle);
+    removed.push_back(0);
+
+    uint32_t id;
+
+    if (not free_ids.empty()) {
+        id = free_ids.back();
+        free_ids.pop_back();
+
+    } else {
+        id = generations.size();
+        index_of_id.push_back(0);
+        generations.push_back(0);
+    }
+
+    handle_id.push_back(id);
+    index_of_id[id] = size() - 1;
+
+    return size() - 1;
+}
+
+void EntityStore::save_positions()
+{
+    std::copy(real_x.begin(), real_x.end(), prev_x.begin());
+    std::copy(real_y.begin(), real_y.end(), prev_y.begin());
+    std::copy(real_z.begin(), real_z.end(), prev_z.begin());
+}
+
+void EntityStore::remove(unsigned int i)
+{
+    if (not removed[i]) {
+        removed[i] = 1;
+        removed_pos.push_back(i);
+    }
+}
+
+void EntityStore::compact()
+{
+    // Highest index first: everything above the current hole has already
+    // been dropped, so the last entity is always a live one.
+    std::sort(removed_pos.begin(),
+              removed_pos.end(),
+              std::greater<unsigned int>());
+
+    for (auto pos: removed_pos) {
+        unsigned int last = size() - 1;
+
+        if (pos != last) {
+            move(pos, last);
+        }
+
+        pop_back();
+    }
+
+    removed_pos.clear();
+}
+
+void EntityStore::move(unsigned int to, unsigned int from)
+{
+    appearance_timestamp[to] = appearance_timestamp[from];
+    last_shot_timestamp[to] = last_shot_timestamp[from];
+    coords_x[to] = coords_x[from];
+    coords_y[to] = coords_y[from];
+    coords_z[to] = coords_z[from];
+    real_x[to] = real_x[from];
+    real_y[to] = real_y[from];
+    real_z[to] = real_z[from];
+    prev_x[to] = prev_x[from];
+    prev_y[to] = prev_y[from];
+    prev_z[to] = prev_z[from];
+    obj_type[to] = obj_type[from];
+    model[to] = model[from];
+    removed[to] = removed[from];
+
+    // The entity at to is being dropped; from takes over its slot.
+    std::swap(handle_id[to], handle_id[from]);
+    index_of_id[handle_id[to]] = to;
+}
+
+void EntityStore::pop_back()
+{
+    appearance_timestamp.pop_back();
+    last_shot_timestamp.pop_back();
+    coords_x.pop_back();
+    coords_y.pop_back();
+    coords_z.pop_back();
+    real_x.pop_back();
+    real_y.pop_back();
+    real_z.pop_back();
+    prev_x.pop_back();
+    prev_y.pop_back();
+    prev_z.pop_back();
+    obj_type.pop_back();
+    model.pop_back();
+    removed.pop_back();
+
+    generations[handle_id.back()]++;
+    free_ids.push_back(handle_id.back());
+    handle_id.pop_back();
+}
@@ -0,0 +1,175 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+
+enum ObjTypes
+{
+    ASTEROID1,
+    ASTEROID2,
+    PLASM_BALL,
+    DUST,
+    E45,
+    WRAITH,
+    VULCAN,
+    EXPLOSION,
+    ASTEROID_FRAGMENT,
+    OBJ_TYPE_COUNT
+};
+
+// Index into the renderer's model table.
+enum ModelHandle
+{
+    E45_MODEL,
+    WRAITH_MODEL,
+    VULCAN_MODEL,
+    ASTEROID1_MODEL,
+    ASTEROID2_MODEL,
+    SPHERE_MODEL,
+    MODEL_COUNT
+};
+
+// Stable reference to an entity. Indices change when compact() moves
+// entities around; a handle keeps naming the same entity, and stops
+// resolving once that entity is gone.
+struct EntityHandle
+{
+    uint32_t id;
+    uint32_t generation;
+};
+
+// Structure-of-arrays storage for one class of entities. Every attribute
+// lives in its own contiguous array, so update and collision loops stream
+// through just the columns they need.
+//
+// Removal is deferred: remove() marks an entity and compact() drops all
+// marked entities at once by moving the last entity into each hole. Entity
+// order is therefore not preserved across compact().
+class EntityStore
+{
+public:
+    std::vector<float> appearance_timestamp;
+    std::vector<float> last_shot_timestamp;
+
+    // Spawn position.
+    std::vector<float> coords_x;
+    std::vector<float> coords_y;
+    std::vector<float> coords_z;
+
+    // Current position.
+    std::vector<float> real_x;
+    std::vector<float> real_y;
+    std::vector<float> real_z;
+
+    // Position at the previous tick, for swept collision and interpolation.
+    std::vector<float> prev_x;
+    std::vector<float> prev_y;
+    std::vector<float> prev_z;
+
+    std::vector<unsigned char> obj_type;
+    std::vector<unsigned char> model;
+
+    // Handle id of each entity.
+    std::vector<uint32_t> handle_id;
+
+    explicit EntityStore(unsigned int capacity = 0);
+
+    // Makes room for capacity entities, so that adding up to that many
+    // doesn't allocate.
+    void reserve(unsigned int capacity);
+
+    unsigned int size() const { return appearance_timestamp.size(); }
+    bool empty() const { return appearance_timestamp.empty(); }
+
+    // Appends an entity and returns its index. The current and previous
+    // positions start out at the spawn position, the direction at zero.
+    unsigned int add(float timestamp,
+                     const glm::vec3 &coords,
+                     ObjTypes type,
+                     ModelHandle model_handle);
+
+    EntityHandle handle(unsigned int i) const
+    {
+        return EntityHandle {handle_id[i], generations[handle_id[i]]};
+    }
+
+    // Sets i to the current index of the entity and returns true, or
+    // returns false if the entity has been dropped.
+    bool find(const EntityHandle &handle, unsigned int &i) const
+    {
+        if (generations[handle.id] != handle.generation) {
+            return false;
+        }
+
+        i = index_of_id[handle.id];
+        return true;
+    }
+
+    glm::vec3 coords(unsigned int i) const
+    {
+        return glm::vec3(coords_x[i], coords_y[i], coords_z[i]);
+    }
+
+    glm::vec3 real_coords(unsigned int i) const
+    {
+        return glm::vec3(real_x[i], real_y[i], real_z[i]);
+    }
+
+    glm::vec3 prev_coords(unsigned int i) const
+    {
+        return glm::vec3(prev_x[i], prev_y[i], prev_z[i]);
+    }
+
+    // Position blended between the previous and the current tick.
+    glm::vec3 interpolated_coords(unsigned int i, float alpha) const
+    {
+        return glm::mix(prev_coords(i), real_coords(i), alpha);
+    }
+
+    void set_real_coords(unsigned int i, const glm::vec3 &real_coords)
+    {
+        real_x[i] = real_coords.x;
+        real_y[i] = real_coords.y;
+        real_z[i] = real_coords.z;
+    }
+
+    // Puts entity i at position without sweeping from where it was.
+    void place(unsigned int i, const glm::vec3 &position)
+    {
+        set_real_coords(i, position);
+        prev_x[i] = position.x;
+        prev_y[i] = position.y;
+        prev_z[i] = position.z;
+    }
+
+    // Copies every current position to the previous one; called by the
+    // movement passes before they compute the new positions.
+    void save_positions();
+
+    // Marks entity i for removal by the next compact(). Marking twice is
+    // harmless.
+    void remove(unsigned int i);
+
+    // Swap-and-pop every entity marked since the last call.
+    void compact();
+
+private:
+    void move(unsigned int to, unsigned int from);
+    void pop_back();
+
+    std::vector<unsigned char> removed;
+    std::vector<unsigned int> removed_pos;
+
+    // Indexed by handle id. A handle id is recycled once its entity is
+    // dropped, with the generation bumped so that old handles go stale.
+    std::vector<uint32_t> index_of_id;
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> free_ids;
+};
+
+
+#endif
@@ -0,0 +1,31 @@
+#include "frame_constants.h"
+
+
+void FrameConstantsBuffer::upload(const FrameConstants &constants)
+{
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, buffer);
+    }
+
+    // Orphaned like the instance buffers, so that the previous frame's
+    // draws needn't finish first.
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER,
+                 sizeof(FrameConstants),
+                 nullptr,
+                 GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER,
+                    0,
+                    sizeof(FrameConstants),
+                    &constants);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameConstantsBuffer::release()
+{
+    if (buffer != 0) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+
+// Uniform buffer binding point of the FrameConstants block, shared by
+// every program that declares it.
+#define FRAME_CONSTANTS_BINDING 0
+
+// Camera state every 3D shader reads, computed once per frame. The layout
+// matches the std140 FrameConstants block in the shaders: three matrices,
+// then a vec3 whose 16-byte slot time fills.
+struct FrameConstants
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_projection;
+    glm::vec3 camera_position;
+    float time;
+};
+
+static_assert(sizeof(FrameConstants) == 3 * 64 + 16,
+              "FrameConstants must match the std140 block layout");
+
+// The uniform buffer holding FrameConstants, bound at
+// FRAME_CONSTANTS_BINDING.
+class FrameConstantsBuffer
+{
+public:
+    FrameConstantsBuffer() : buffer {0} {}
+
+    // Replaces the buffer's contents, creating and binding it on first use.
+    void upload(const FrameConstants &constants);
+
+    // Frees the GL buffer; needs the context that created it.
+    void release();
+
+private:
+    GLuint buffer;
+};
+
+
+#endif
@@ -0,0 +1,68 @@
+#include "frame_snapshot.h"
+
+#include <algorithm>
+
+
+static void capture_store(const EntityStore &store,
+                          float alpha,
+                          float render_time,
+                          std::vector<SnapshotEntity> &entities)
+{
+    unsigned int n = store.size();
+    entities.resize(n);
+
+    for (unsigned int i = 0; i < n; i++) {
+        SnapshotEntity &entity = entities[i];
+
+        entity.position = store.interpolated_coords(i, alpha);
+        entity.age = std::max(render_time - store.appearance_timestamp[i],
+                              0.0f);
+        entity.obj_type = store.obj_type[i];
+        entity.model = store.model[i];
+    }
+}
+
+void capture_snapshot(const Simulation &simulation,
+                      float alpha,
+                      float dt,
+                      FrameSnapshot &snapshot)
+{
+    float render_time = simulation.interpolated_time(alpha, dt);
+
+    capture_store(simulation.starships,
+                  alpha,
+                  render_time,
+                  snapshot.starships);
+
+    capture_store(simulation.asteroids,
+                  alpha,
+                  render_time,
+                  snapshot.asteroids);
+
+    capture_store(simulation.plasm_balls,
+                  alpha,
+                  render_time,
+                  snapshot.plasm_balls);
+
+    capture_store(simulation.enemy_plasm_balls,
+                  alpha,
+                  render_time,
+                  snapshot.enemy_plasm_balls);
+
+    capture_store(simulation.explosions,
+                  alpha,
+                  render_time,
+                  snapshot.explosions);
+
+    std::copy(simulation.debris_bursts,
+              simulation.debris_bursts + DEBRIS_BURSTS,
+              snapshot.debris_bursts);
+    snapshot.debris_burst_count = simulation.debris_burst_count;
+
+    snapshot.score = simulation.score;
+    snapshot.health = simulation.health;
+    snapshot.time = render_time;
+    snapshot.game_over = simulation.game_over;
+    snapshot.game_over_elapsed = simulation.game_over ?
+            simulation.time() - simulation.game_over_timestamp : 0.0f;
+}
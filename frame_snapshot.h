@@ -0,0 +1,66 @@
+#ifndef FRAME_SNAPSHOT_H
+#define FRAME_SNAPSHOT_H
+
+#include "simulation.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// One entity as the renderer sees it.
+struct SnapshotEntity
+{
+    // Blended between the last two ticks.
+    glm::vec3 position;
+
+    // Seconds since the entity appeared, at render time.
+    float age;
+
+    unsigned char obj_type;
+    unsigned char model;
+};
+
+// Everything a frame draws, copied out of the simulation so that the
+// render thread never touches live gameplay state. The frontend fills in
+// the camera.
+struct FrameSnapshot
+{
+    std::vector<SnapshotEntity> starships;
+    std::vector<SnapshotEntity> asteroids;
+    std::vector<SnapshotEntity> plasm_balls;
+    std::vector<SnapshotEntity> enemy_plasm_balls;
+    std::vector<SnapshotEntity> explosions;
+
+    // Where the debris particles start, as in Simulation, and how many
+    // bursts there have been so far.
+    DebrisBurst debris_bursts[DEBRIS_BURSTS];
+    unsigned int debris_burst_count;
+
+    glm::mat4 view;
+    glm::vec3 camera_position;
+    float zoom;
+    int framebuffer_width;
+    int framebuffer_height;
+
+    // Simulation time the frame shows.
+    float time;
+
+    int score;
+    int health;
+    bool game_over;
+
+    // Seconds since the game ended.
+    float game_over_elapsed;
+};
+
+// Copies the world as of alpha of the way between the last two ticks of
+// length dt into snapshot. Only grows snapshot's arrays, so refilling the
+// same snapshot soon stops allocating.
+void capture_snapshot(const Simulation &simulation,
+                      float alpha,
+                      float dt,
+                      FrameSnapshot &snapshot);
+
+
+#endif
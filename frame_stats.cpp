@@ -0,0 +1,47 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+
+static double percentile(const std::vector<float> &sorted, double p)
+{
+    unsigned long i = (unsigned long) (p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+FrameStats summarize_frame_times(std::vector<float> &frame_ms)
+{
+    FrameStats stats = FrameStats();
+
+    if (frame_ms.empty()) {
+        return stats;
+    }
+
+    std::sort(frame_ms.begin(), frame_ms.end());
+
+    for (auto ms: frame_ms) {
+        stats.total_ms += ms;
+    }
+
+    stats.frames = frame_ms.size();
+    stats.mean_ms = stats.total_ms / stats.frames;
+    stats.p50_ms = percentile(frame_ms, 0.50);
+    stats.p95_ms = percentile(frame_ms, 0.95);
+    stats.p99_ms = percentile(frame_ms, 0.99);
+    stats.max_ms = frame_ms.back();
+
+    return stats;
+}
+
+void print_frame_stats(const char *label, const FrameStats &stats)
+{
+    std::printf("%s: %lu, total %.3f ms\n", label, stats.frames, stats.total_ms);
+    std::printf("    mean %.4f ms, p50 %.4f ms, p95 %.4f ms, p99 %.4f ms, "
+                "max %.4f ms\n",
+                stats.mean_ms,
+                stats.p50_ms,
+                stats.p95_ms,
+                stats.p99_ms,
+                stats.max_ms);
+}
@@ -0,0 +1,26 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <vector>
+
+
+// Distribution of per-frame (or per-tick) wall times, in milliseconds.
+struct FrameStats
+{
+    unsigned long frames;
+    double total_ms;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+// Summarises frame_ms, sorting it in place.
+FrameStats summarize_frame_times(std::vector<float> &frame_ms);
+
+// Prints stats as one labelled block to stdout.
+void print_frame_stats(const char *label, const FrameStats &stats);
+
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+
+// The six planes bounding what a view-projection matrix shows, pointing
+// inwards, extracted from the matrix rows (Gribb and Hartmann).
+class Frustum
+{
+public:
+    Frustum() {}
+
+    explicit Frustum(const glm::mat4 &view_projection)
+    {
+        // glm is column-major: row i is m[0][i], m[1][i], m[2][i], m[3][i].
+        glm::vec4 rows[4];
+
+        for (unsigned int i = 0; i < 4; i++) {
+            rows[i] = glm::vec4(view_projection[0][i],
+                                view_projection[1][i],
+                                view_projection[2][i],
+                                view_projection[3][i]);
+        }
+
+        for (unsigned int axis = 0; axis < 3; axis++) {
+            planes[2 * axis] = rows[3] + rows[axis];
+            planes[2 * axis + 1] = rows[3] - rows[axis];
+        }
+
+        for (auto &plane: planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    // Whether any of the sphere may be visible. Spheres near a corner can
+    // pass without being visible, which only costs a draw.
+    bool intersects_sphere(const glm::vec3 &center, float radius) const
+    {
+        for (auto &plane: planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    // Left, right, bottom, top, near, far.
+    glm::vec4 planes[6];
+};
+
+
+#endif
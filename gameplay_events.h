@@ -0,0 +1,71 @@
+#ifndef GAMEPLAY_EVENTS_H
+#define GAMEPLAY_EVENTS_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// Stands for "no entity" where an event may or may not name one.
+static const unsigned int NO_ENTITY = 0xffffffff;
+
+// A player plasm ball hit a ship or an asteroid and is used up.
+struct HitEvent
+{
+    unsigned int plasm_ball;
+    int score;
+};
+
+// The player lost health, rammed by a ship or an asteroid (which is
+// destroyed by an event of its own) or hit by enemy fire.
+struct PlayerDamagedEvent
+{
+    int damage;
+
+    // The enemy plasm ball that hit, or NO_ENTITY.
+    unsigned int enemy_plasm_ball;
+};
+
+struct ShipDestroyedEvent
+{
+    unsigned int starship;
+    glm::vec3 explosion;
+};
+
+struct AsteroidShatteredEvent
+{
+    unsigned int asteroid;
+    glm::vec3 position;
+    glm::vec3 explosion;
+};
+
+// Side effects of one tick's collisions, one array per event type. The
+// collision passes only append to it; the simulation then applies each
+// array in one go, in the order the events were raised. Entity indices
+// are those of the tick the events were raised in.
+struct GameplayEvents
+{
+    std::vector<HitEvent> hits;
+    std::vector<PlayerDamagedEvent> player_damage;
+    std::vector<ShipDestroyedEvent> ships_destroyed;
+    std::vector<AsteroidShatteredEvent> asteroids_shattered;
+
+    void reserve(unsigned int capacity)
+    {
+        hits.reserve(capacity);
+        player_damage.reserve(capacity);
+        ships_destroyed.reserve(capacity);
+        asteroids_shattered.reserve(capacity);
+    }
+
+    void clear()
+    {
+        hits.clear();
+        player_damage.clear();
+        ships_destroyed.clear();
+        asteroids_shattered.clear();
+    }
+};
+
+
+#endif
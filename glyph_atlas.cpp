@@ -0,0 +1,424 @@
+#include "glyph_atlas.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+
+// Glyphs are rendered at this many times PIXEL_SIZE and their distance
+// fields sampled back down, so that outlines keep subpixel precision.
+static const unsigned int SDF_UPSCALE = 4;
+
+// Squared distance of pixels with no feature in reach.
+static const float FAR = 1e20f;
+
+static const unsigned int ATLAS_WIDTH = GlyphAtlas::COLUMNS *
+                                        GlyphAtlas::CELL_SIZE;
+
+// Rows of cells the texture starts with.
+static const unsigned int INITIAL_ROWS = 4;
+
+const unsigned int GlyphAtlas::PIXEL_SIZE;
+const unsigned int GlyphAtlas::SPREAD;
+const unsigned int GlyphAtlas::CELL_SIZE;
+const unsigned int GlyphAtlas::COLUMNS;
+const uint32_t GlyphAtlas::NIL;
+
+
+GlyphAtlas::GlyphAtlas(unsigned int budget)
+    : library {nullptr},
+      face {nullptr},
+      budget {budget},
+      frame {0},
+      evicted {0},
+      newest {NIL},
+      oldest {NIL},
+      rows {0},
+      texture {0},
+      resized {false}
+{
+    std::fill(ascii, ascii + 128, NIL);
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    if (face != nullptr) {
+        FT_Done_Face(face);
+    }
+
+    if (library != nullptr) {
+        FT_Done_FreeType(library);
+    }
+}
+
+bool GlyphAtlas::load(const char *font_path)
+{
+    if (library == nullptr and FT_Init_FreeType(&library)) {
+        std::cout << "ERROR::FREETYPE: Could not init FreeType Library"
+                  << std::endl;
+        library = nullptr;
+        return false;
+    }
+
+    if (face != nullptr) {
+        FT_Done_Face(face);
+        face = nullptr;
+    }
+
+    if (FT_New_Face(library, font_path, 0, &face)) {
+        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+        face = nullptr;
+        return false;
+    }
+
+    FT_Set_Pixel_Sizes(face, 0, PIXEL_SIZE * SDF_UPSCALE);
+
+    return true;
+}
+
+const Glyph &GlyphAtlas::glyph(uint32_t code)
+{
+    uint32_t slot = find(code);
+
+    if (slot == NIL) {
+        slot = allocate();
+        rasterize(code, slot);
+        remember(code, slot);
+        upload(slot);
+
+    } else {
+        unlink(slot);
+    }
+
+    push_front(slot);
+    slots[slot].frame = frame;
+
+    return slots[slot].glyph;
+}
+
+void GlyphAtlas::release()
+{
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+
+    slots.clear();
+    std::fill(ascii, ascii + 128, NIL);
+    other.clear();
+
+    newest = NIL;
+    oldest = NIL;
+
+    pixels.clear();
+    rows = 0;
+}
+
+uint32_t GlyphAtlas::find(uint32_t code) const
+{
+    if (code < 128) {
+        return ascii[code];
+    }
+
+    auto entry = other.find(code);
+    return entry != other.end() ? entry->second : NIL;
+}
+
+void GlyphAtlas::remember(uint32_t code, uint32_t slot)
+{
+    slots[slot].code = code;
+
+    if (code < 128) {
+        ascii[code] = slot;
+
+    } else {
+        other[code] = slot;
+    }
+}
+
+void GlyphAtlas::forget(uint32_t code)
+{
+    if (code < 128) {
+        ascii[code] = NIL;
+
+    } else {
+        other.erase(code);
+    }
+}
+
+// A cell for a new glyph, not linked into the recency list.
+uint32_t GlyphAtlas::allocate()
+{
+    if (slots.size() >= budget and oldest != NIL and
+            slots[oldest].frame != frame) {
+
+        uint32_t slot = oldest;
+
+        forget(slots[slot].code);
+        unlink(slot);
+        evicted++;
+
+        return slot;
+    }
+
+    uint32_t slot = slots.size();
+    slots.push_back(Slot());
+
+    // Rows are appended below the existing ones, so the copy keeps its
+    // layout and only has to be uploaded again as a whole.
+    if (slots.size() > rows * COLUMNS) {
+        unsigned int needed = (slots.size() + COLUMNS - 1) / COLUMNS;
+        unsigned int limit = std::max((budget + COLUMNS - 1) / COLUMNS,
+                                      needed);
+
+        rows = std::min(std::max(rows * 2, INITIAL_ROWS), limit);
+        pixels.resize(rows * CELL_SIZE * ATLAS_WIDTH, 0);
+        resized = true;
+    }
+
+    return slot;
+}
+
+void GlyphAtlas::unlink(uint32_t slot)
+{
+    Slot &entry = slots[slot];
+
+    if (entry.prev != NIL) {
+        slots[entry.prev].next = entry.next;
+
+    } else {
+        newest = entry.next;
+    }
+
+    if (entry.next != NIL) {
+        slots[entry.next].prev = entry.prev;
+
+    } else {
+        oldest = entry.prev;
+    }
+}
+
+void GlyphAtlas::push_front(uint32_t slot)
+{
+    slots[slot].prev = NIL;
+    slots[slot].next = newest;
+
+    if (newest != NIL) {
+        slots[newest].prev = slot;
+
+    } else {
+        oldest = slot;
+    }
+
+    newest = slot;
+}
+
+// Renders the glyph into its cell of the copy and fills in its metrics.
+// Glyphs FreeType can't load come out blank.
+void GlyphAtlas::rasterize(uint32_t code, uint32_t slot)
+{
+    unsigned int cell_x = (slot % COLUMNS) * CELL_SIZE;
+    unsigned int cell_y = (slot / COLUMNS) * CELL_SIZE;
+
+    for (unsigned int y = 0; y < CELL_SIZE; y++) {
+        std::memset(&pixels[(cell_y + y) * ATLAS_WIDTH + cell_x], 0, CELL_SIZE);
+    }
+
+    Glyph &glyph = slots[slot].glyph;
+
+    glyph = Glyph();
+    glyph.texel_min = glm::vec2(cell_x, cell_y);
+    glyph.texel_max = glyph.texel_min;
+
+    if (face == nullptr or FT_Load_Char(face, code, FT_LOAD_RENDER)) {
+        return;
+    }
+
+    const FT_Bitmap &bitmap = face->glyph->bitmap;
+
+    glyph.advance = face->glyph->advance.x / (64.0f * SDF_UPSCALE);
+
+    if (bitmap.width == 0 or bitmap.rows == 0) {
+        return;
+    }
+
+    // The field covers the bitmap and SPREAD pixels around it, rounded up
+    // to whole atlas pixels.
+    unsigned int pad = SPREAD * SDF_UPSCALE;
+
+    unsigned int field_width =
+            (bitmap.width + 2 * pad + SDF_UPSCALE - 1) / SDF_UPSCALE;
+    unsigned int field_height =
+            (bitmap.rows + 2 * pad + SDF_UPSCALE - 1) / SDF_UPSCALE;
+
+    unsigned int high_width = field_width * SDF_UPSCALE;
+    unsigned int high_height = field_height * SDF_UPSCALE;
+
+    outside.assign(high_width * high_height, FAR);
+    inside.assign(high_width * high_height, 0.0f);
+
+    for (unsigned int y = 0; y < bitmap.rows; y++) {
+        const unsigned char *row = bitmap.buffer + (int) y * bitmap.pitch;
+
+        for (unsigned int x = 0; x < bitmap.width; x++) {
+            if (row[x] >= 128) {
+                unsigned int i = (y + pad) * high_width + x + pad;
+
+                outside[i] = 0.0f;
+                inside[i] = FAR;
+            }
+        }
+    }
+
+    distance_transform(outside, high_width, high_height);
+    distance_transform(inside, high_width, high_height);
+
+    // A glyph too large for a cell loses its right and bottom edges.
+    unsigned int width = std::min(field_width, CELL_SIZE);
+    unsigned int height = std::min(field_height, CELL_SIZE);
+
+    for (unsigned int y = 0; y < height; y++) {
+        for (unsigned int x = 0; x < width; x++) {
+            unsigned int i = (y * SDF_UPSCALE + SDF_UPSCALE / 2) * high_width +
+                             x * SDF_UPSCALE + SDF_UPSCALE / 2;
+
+            float distance = (std::sqrt(outside[i]) - std::sqrt(inside[i])) /
+                             SDF_UPSCALE;
+
+            float value = 0.5f - distance / (2.0f * SPREAD);
+            value = std::min(std::max(value, 0.0f), 1.0f);
+
+            pixels[(cell_y + y) * ATLAS_WIDTH + cell_x + x] =
+                    (unsigned char) (255.0f * value + 0.5f);
+        }
+    }
+
+    glyph.size = glm::vec2(width, height);
+    glyph.bearing = glm::vec2(
+            ((float) face->glyph->bitmap_left - pad) / SDF_UPSCALE,
+            ((float) face->glyph->bitmap_top + pad) / SDF_UPSCALE);
+    glyph.texel_max = glyph.texel_min + glyph.size;
+}
+
+// Replaces every value of field, 0 on features and FAR elsewhere, with
+// the squared distance to the nearest feature pixel. Exact Euclidean
+// distance transform of Felzenszwalb and Huttenlocher: one pass along
+// every column, then one along every row, each finding the lower envelope
+// of the parabolas rooted at the values.
+void GlyphAtlas::distance_transform(std::vector<float> &field,
+                                    unsigned int width,
+                                    unsigned int height)
+{
+    unsigned int longest = std::max(width, height);
+
+    line.resize(longest);
+    envelope.resize(longest + 1);
+    parabolas.resize(longest);
+
+    for (unsigned int pass = 0; pass < 2; pass++) {
+        unsigned int lines = pass == 0 ? width : height;
+        unsigned int count = pass == 0 ? height : width;
+        unsigned int stride = pass == 0 ? width : 1;
+        unsigned int step = pass == 0 ? 1 : width;
+
+        for (unsigned int l = 0; l < lines; l++) {
+            float *values = &field[l * step];
+
+            for (unsigned int q = 0; q < count; q++) {
+                line[q] = values[q * stride];
+            }
+
+            int k = 0;
+            parabolas[0] = 0;
+            envelope[0] = -std::numeric_limits<float>::infinity();
+            envelope[1] = std::numeric_limits<float>::infinity();
+
+            for (int q = 1; q < (int) count; q++) {
+                float s;
+
+                for (;;) {
+                    int p = parabolas[k];
+                    s = ((line[q] + q * q) - (line[p] + p * p)) /
+                        (2.0f * (q - p));
+
+                    if (s > envelope[k]) {
+                        break;
+                    }
+
+                    k--;
+                }
+
+                k++;
+                parabolas[k] = q;
+                envelope[k] = s;
+                envelope[k + 1] = std::numeric_limits<float>::infinity();
+            }
+
+            k = 0;
+
+            for (int q = 0; q < (int) count; q++) {
+                while (envelope[k + 1] < q) {
+                    k++;
+                }
+
+                int p = parabolas[k];
+                values[q * stride] = (q - p) * (q - p) + line[p];
+            }
+        }
+    }
+}
+
+void GlyphAtlas::upload(uint32_t slot)
+{
+    if (texture == 0) {
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    } else {
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (resized) {
+        glTexImage2D(GL_TEXTURE_2D,
+                     0,
+                     GL_RED,
+                     ATLAS_WIDTH,
+                     rows * CELL_SIZE,
+                     0,
+                     GL_RED,
+                     GL_UNSIGNED_BYTE,
+                     pixels.data());
+
+        resized = false;
+
+    } else {
+        unsigned int cell_x = (slot % COLUMNS) * CELL_SIZE;
+        unsigned int cell_y = (slot / COLUMNS) * CELL_SIZE;
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, ATLAS_WIDTH);
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        cell_x,
+                        cell_y,
+                        CELL_SIZE,
+                        CELL_SIZE,
+                        GL_RED,
+                        GL_UNSIGNED_BYTE,
+                        &pixels[cell_y * ATLAS_WIDTH + cell_x]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
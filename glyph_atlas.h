@@ -0,0 +1,134 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+
+// Quad of one glyph relative to the pen, in pixels at an em size of
+// GlyphAtlas::PIXEL_SIZE: its size, the offset of its top left corner and
+// how far the pen moves on. texel_min and texel_max are the corners of its
+// distance field in the atlas, in texels.
+struct Glyph
+{
+    glm::vec2 size;
+    glm::vec2 bearing;
+    float advance;
+
+    glm::vec2 texel_min;
+    glm::vec2 texel_max;
+};
+
+// Signed distance fields of the glyphs of a font, generated on first use
+// into one single-channel texture. A texel holds 0.5 on the outline and
+// moves towards 1 inside and 0 outside by 0.5 / SPREAD per pixel, so the
+// same field renders sharp outlines at any size.
+//
+// The atlas is a grid of CELL_SIZE cells, one glyph each, and grows by
+// adding rows, which leaves texel coordinates of cached glyphs valid. Once
+// it holds budget glyphs, a new one takes the cell of the least recently
+// used glyph instead, unless that one was used in the current frame.
+class GlyphAtlas
+{
+public:
+    static const unsigned int PIXEL_SIZE = 32;
+    static const unsigned int SPREAD = 4;
+    static const unsigned int CELL_SIZE = 40;
+    static const unsigned int COLUMNS = 16;
+
+    explicit GlyphAtlas(unsigned int budget = 256);
+    ~GlyphAtlas();
+
+    GlyphAtlas(const GlyphAtlas &) = delete;
+    GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+    // Opens the font; no glyph is rasterized yet. Returns false if
+    // FreeType can't open it.
+    bool load(const char *font_path);
+
+    // Starts a frame: glyphs looked up from now on aren't evicted before
+    // the next call, so quads laid out this frame stay valid.
+    void begin_frame() { frame++; }
+
+    // Glyph of the Unicode code point code, rasterized and uploaded if it
+    // isn't cached. Needs the GL context.
+    const Glyph &glyph(uint32_t code);
+
+    GLuint id() const { return texture; }
+
+    unsigned int cached() const { return slots.size(); }
+    unsigned int evictions() const { return evicted; }
+
+    // Frees the GL texture and forgets every glyph; needs the context that
+    // created it.
+    void release();
+
+private:
+    static const uint32_t NIL = 0xffffffff;
+
+    struct Slot
+    {
+        uint32_t code;
+        uint64_t frame;
+
+        // Neighbours in recency order, most recently used first.
+        uint32_t prev;
+        uint32_t next;
+
+        Glyph glyph;
+    };
+
+    uint32_t find(uint32_t code) const;
+    void remember(uint32_t code, uint32_t slot);
+    void forget(uint32_t code);
+
+    uint32_t allocate();
+    void unlink(uint32_t slot);
+    void push_front(uint32_t slot);
+
+    void rasterize(uint32_t code, uint32_t slot);
+    void distance_transform(std::vector<float> &field,
+                            unsigned int width,
+                            unsigned int height);
+    void upload(uint32_t slot);
+
+    FT_LibraryRec_ *library;
+    FT_FaceRec_ *face;
+
+    unsigned int budget;
+    uint64_t frame;
+    unsigned int evicted;
+
+    // Slot of each cached glyph. Slot i sits in cell i of the grid.
+    std::vector<Slot> slots;
+    uint32_t ascii[128];
+    std::unordered_map<uint32_t, uint32_t> other;
+
+    uint32_t newest;
+    uint32_t oldest;
+
+    // Copy of the texture, COLUMNS cells wide and rows cells high.
+    std::vector<unsigned char> pixels;
+    unsigned int rows;
+
+    GLuint texture;
+    bool resized;
+
+    // Scratch space of rasterize(), kept to avoid reallocating.
+    std::vector<float> outside;
+    std::vector<float> inside;
+    std::vector<float> line;
+    std::vector<float> envelope;
+    std::vector<int> parabolas;
+};
+
+
+#endif
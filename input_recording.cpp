@@ -0,0 +1,106 @@
+#include "input_recording.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+
+static const char MAGIC[4] = {'S', 'B', 'I', 'R'};
+static const uint32_t VERSION = 1;
+
+template <typename T>
+static void write(std::ofstream &file, const T &value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool read(std::ifstream &file, T &value)
+{
+    return (bool) file.read(reinterpret_cast<char *>(&value), sizeof(value));
+}
+
+bool InputRecording::save(const char *path) const
+{
+    std::ofstream file(path, std::ios::binary);
+
+    if (not file) {
+        return false;
+    }
+
+    file.write(MAGIC, sizeof(MAGIC));
+    write(file, VERSION);
+    write(file, seed);
+    write(file, tick);
+    write(file, (uint64_t) ticks.size());
+
+    for (auto &input: ticks) {
+        write(file, input.flags);
+
+        if (input.flags & INPUT_LOOK) {
+            write(file, input.look_x);
+            write(file, input.look_y);
+        }
+
+        if (input.flags & INPUT_FIRE) {
+            write(file, input.fire_direction.x);
+            write(file, input.fire_direction.y);
+            write(file, input.fire_direction.z);
+        }
+    }
+
+    return (bool) file;
+}
+
+bool InputRecording::load(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version;
+    uint64_t count;
+
+    if (not file.read(magic, sizeof(magic)) or
+            std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 or
+            not read(file, version) or version != VERSION or
+            not read(file, seed) or
+            not read(file, tick) or
+            not read(file, count)) {
+
+        return false;
+    }
+
+    // The count comes from the file; don't let a corrupt one reserve
+    // gigabytes up front.
+    ticks.clear();
+    ticks.reserve(std::min(count, (uint64_t) 1 << 20));
+
+    for (uint64_t i = 0; i < count; i++) {
+        TickInput input = TickInput();
+
+        if (not read(file, input.flags)) {
+            return false;
+        }
+
+        if (input.flags & INPUT_LOOK) {
+            if (not read(file, input.look_x) or
+                    not read(file, input.look_y)) {
+
+                return false;
+            }
+        }
+
+        if (input.flags & INPUT_FIRE) {
+            if (not read(file, input.fire_direction.x) or
+                    not read(file, input.fire_direction.y) or
+                    not read(file, input.fire_direction.z)) {
+
+                return false;
+            }
+        }
+
+        ticks.push_back(input);
+    }
+
+    return true;
+}
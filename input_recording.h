@@ -0,0 +1,60 @@
+#ifndef INPUT_RECORDING_H
+#define INPUT_RECORDING_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+
+enum InputFlags
+{
+    INPUT_MOVE_LEFT = 1,
+    INPUT_MOVE_RIGHT = 2,
+    INPUT_FIRE = 4,
+    INPUT_LOOK = 8,
+
+    // Tops the player's health up before the tick. sim_bench sets it so
+    // that dense runs never end, and records it so that replays don't
+    // either.
+    INPUT_KEEP_ALIVE = 16
+};
+
+// Everything the player did between two simulation ticks. The frontend
+// fills one in from live input, or takes it from a recording, and applies
+// it right before the tick either way.
+struct TickInput
+{
+    uint8_t flags;
+
+    // Mouse offsets, as passed to Camera::ProcessMouseMovement().
+    float look_x;
+    float look_y;
+
+    // Aim at the moment of the shot, so that a replay hits exactly the
+    // same targets whatever the camera does.
+    glm::vec3 fire_direction;
+};
+
+// Per-tick input of a whole session plus what is needed to replay it: the
+// seed of the random streams and the tick length.
+//
+// On disk: the magic "SBIR", a format version, the seed, the tick length
+// and the tick count, then one flags byte per tick followed by the look
+// offsets and the fire direction only if the flags say they are there.
+// Values are stored in the byte order of the machine that wrote them.
+class InputRecording
+{
+public:
+    uint64_t seed;
+    float tick;
+    std::vector<TickInput> ticks;
+
+    InputRecording() : seed {0}, tick {0.0f} {}
+
+    bool save(const char *path) const;
+    bool load(const char *path);
+};
+
+
+#endif
@@ -0,0 +1,42 @@
+#include "instance_buffer.h"
+
+
+void InstanceBuffer::upload()
+{
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+    }
+
+    unsigned int size = transforms.size();
+
+    if (size > capacity) {
+        capacity = capacity == 0 ? 256 : capacity;
+        while (capacity < size) {
+            capacity *= 2;
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER,
+                 capacity * sizeof(glm::mat4),
+                 nullptr,
+                 GL_STREAM_DRAW);
+
+    if (size > 0) {
+        glBufferSubData(GL_ARRAY_BUFFER,
+                        0,
+                        size * sizeof(glm::mat4),
+                        transforms.data());
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::release()
+{
+    if (buffer != 0) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        capacity = 0;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// Model matrices of one class of instanced entities. They are filled on
+// the CPU every frame and streamed into a dynamic vertex buffer. The render
+// queue points Mesh::BindInstanceMatrices() at it, one matrix per instance.
+class InstanceBuffer
+{
+public:
+    std::vector<glm::mat4> transforms;
+
+    InstanceBuffer() : buffer {0}, capacity {0} {}
+
+    // Copies transforms to the GPU. The buffer grows by doubling; its old
+    // contents are orphaned first so that the driver needn't wait for
+    // draws of the previous frame that still read them.
+    void upload();
+
+    GLuint id() const { return buffer; }
+    GLsizei count() const { return transforms.size(); }
+
+    // Frees the GL buffer; needs the context that created it.
+    void release();
+
+private:
+    GLuint buffer;
+    unsigned int capacity;
+};
+
+
+#endif
@@ -0,0 +1,164 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+
+JobSystem::JobSystem(unsigned int threads) : trampoline {nullptr},
+                                             body {nullptr},
+                                             chunks_left {0},
+                                             generation {0},
+                                             stopping {false}
+{
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    queue_count = threads;
+    queues = new Queue[threads];
+
+    for (unsigned int t = 0; t < threads; t++) {
+        queues[t].front = 0;
+        queues[t].back = 0;
+    }
+
+    // The calling thread is thread 0.
+    workers.reserve(threads - 1);
+
+    for (unsigned int t = 1; t < threads; t++) {
+        workers.push_back(std::thread(&JobSystem::worker_main, this, t));
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+
+    wake.notify_all();
+
+    for (auto &worker: workers) {
+        worker.join();
+    }
+
+    delete[] queues;
+}
+
+void JobSystem::run(unsigned int count,
+                    unsigned int grain,
+                    Trampoline trampoline,
+                    const void *body)
+{
+    // Several chunks per thread leave something to steal, but no more than
+    // the queues hold.
+    unsigned int max_chunks = queue_count * QUEUE_CAPACITY;
+    unsigned int size = std::max(grain, (count + max_chunks - 1) / max_chunks);
+    unsigned int chunk_count = (count + size - 1) / size;
+
+    this->trampoline = trampoline;
+    this->body = body;
+    chunks_left.store(chunk_count, std::memory_order_relaxed);
+
+    // Contiguous runs of chunks per queue, so that each thread starts on
+    // neighbouring indices.
+    unsigned int per_queue = (chunk_count + queue_count - 1) / queue_count;
+
+    for (unsigned int t = 0; t < queue_count; t++) {
+        Queue &queue = queues[t];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        queue.front = 0;
+        queue.back = 0;
+
+        for (unsigned int c = t * per_queue;
+                c < std::min((t + 1) * per_queue, chunk_count); c++) {
+
+            queue.chunks[queue.back].begin = c * size;
+            queue.chunks[queue.back].end = std::min((c + 1) * size, count);
+            queue.back++;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        generation++;
+    }
+
+    wake.notify_all();
+
+    work(0);
+
+    // Chunks taken by workers may still be running.
+    while (chunks_left.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+bool JobSystem::pop_back(Queue &queue, Chunk &chunk)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.front == queue.back) {
+        return false;
+    }
+
+    chunk = queue.chunks[--queue.back];
+    return true;
+}
+
+bool JobSystem::pop_front(Queue &queue, Chunk &chunk)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.front == queue.back) {
+        return false;
+    }
+
+    chunk = queue.chunks[queue.front++];
+    return true;
+}
+
+void JobSystem::work(unsigned int thread)
+{
+    Chunk chunk;
+
+    for (;;) {
+        bool found = pop_back(queues[thread], chunk);
+
+        for (unsigned int k = 1; k < queue_count and not found; k++) {
+            found = pop_front(queues[(thread + k) % queue_count], chunk);
+        }
+
+        if (not found) {
+            return;
+        }
+
+        // The queue mutex orders this after run() set the loop up.
+        trampoline(body, chunk.begin, chunk.end, thread);
+        chunks_left.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void JobSystem::worker_main(unsigned int thread)
+{
+    unsigned long seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex);
+
+            wake.wait(lock, [&]() {
+                return stopping or generation != seen;
+            });
+
+            if (stopping) {
+                return;
+            }
+
+            seen = generation;
+        }
+
+        work(thread);
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Pool of worker threads that runs loops over index ranges.
+//
+// parallel_for() cuts the range into chunks and deals them out to one
+// queue per thread, the calling thread included. Every thread works
+// through its own queue from the back and, once that is empty, steals from
+// the front of the others, so threads that finish early take over work
+// from those that don't. Queues have a fixed size and chunks are made
+// large enough to fit, so running a loop doesn't allocate.
+//
+// Loops are meant to be started from one thread at a time, and not from
+// inside another loop.
+class JobSystem
+{
+public:
+    // Threads, counting the calling one; 0 means one per hardware thread.
+    explicit JobSystem(unsigned int threads = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    unsigned int thread_count() const { return queue_count; }
+
+    // Calls body(begin, end, thread) for chunks of at least grain indices
+    // that together cover [0, count) exactly once, and returns when all of
+    // them are done. thread is below thread_count() and no two chunks run
+    // on the same thread at once, so it can index per-thread scratch.
+    // Chunks are not run in any particular order.
+    template <typename Body>
+    void parallel_for(unsigned int count, unsigned int grain, const Body &body)
+    {
+        if (count == 0) {
+            return;
+        }
+
+        if (count <= grain or queue_count == 1) {
+            body(0, count, 0);
+            return;
+        }
+
+        run(count, grain, &call<Body>, &body);
+    }
+
+private:
+    static const unsigned int QUEUE_CAPACITY = 64;
+
+    typedef void (*Trampoline)(const void *body,
+                               unsigned int begin,
+                               unsigned int end,
+                               unsigned int thread);
+
+    template <typename Body>
+    static void call(const void *body,
+                     unsigned int begin,
+                     unsigned int end,
+                     unsigned int thread)
+    {
+        (*static_cast<const Body *>(body))(begin, end, thread);
+    }
+
+    struct Chunk
+    {
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    // Owner takes from the back, thieves from the front.
+    struct Queue
+    {
+        std::mutex mutex;
+        Chunk chunks[QUEUE_CAPACITY];
+        unsigned int front;
+        unsigned int back;
+    };
+
+    void run(unsigned int count,
+             unsigned int grain,
+             Trampoline trampoline,
+             const void *body);
+
+    // Runs chunks, own ones first, until no queue has any left.
+    void work(unsigned int thread);
+
+    bool pop_back(Queue &queue, Chunk &chunk);
+    bool pop_front(Queue &queue, Chunk &chunk);
+
+    void worker_main(unsigned int thread);
+
+    unsigned int queue_count;
+    Queue *queues;
+    std::vector<std::thread> workers;
+
+    // Loop being run.
+    Trampoline trampoline;
+    const void *body;
+    std::atomic<unsigned int> chunks_left;
+
+    // Workers sleep until the generation changes or the pool stops.
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    unsigned long generation;
+    bool stopping;
+};
+
+
+#endif
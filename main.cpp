@@ -1,7 +1,21 @@
 #include "common.h"
 #include "ShaderProgram.h"
+#include "allocation_counter.h"
+#include "frame_constants.h"
+#include "frame_snapshot.h"
+#include "frame_stats.h"
+#include "frustum.h"
+#include "glyph_atlas.h"
+#include "instance_buffer.h"
+#include "input_recording.h"
+#include "scenario.h"
 #include "camera.h"
 #include "model.h"
+#include "particle_system.h"
+#include "render_queue.h"
+#include "simulation.h"
+#include "text_batch.h"
+#include "triple_buffer.h"
 
 #define GLFW_DLL
 #include <GLFW/glfw3.h>
@@ -9,104 +23,39 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <ft2build.h>
-#include FT_FREETYPE_H
 #include <irrKlang.h>
 
 #include <random>
 #include <string>
 #include <vector>
-#include <map>
-#include <set>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <chrono>
 #include <ctime>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 
 
 using namespace irrklang;
 
 #pragma comment(lib, "irrKlang.lib")
 
-#define DIST 2.5f
 #define OUTRO_TIMEOUT 10
 #define STANDART_TEXT_WIDTH 1120
+#define HUD_FONT_SIZE 48
 
 static const GLsizei WIDTH = 640;
 static const GLsizei HEIGHT = 480;
-
-enum ObjTypes
-{
-    ASTEROID1,
-    ASTEROID2,
-    PLASM_BALL,
-    DUST,
-    E45,
-    WRAITH,
-    VULCAN,
-    EXPLOSION
-};
-
-struct ModelAttributes
-{
-    float appearance_timestamp;
-    glm::vec3 coords;
-    Model *model;
-    ObjTypes obj_type;
-    glm::vec3 real_coords;
-
-    ModelAttributes(float ap_ts,
-                    glm::vec3 c,
-                    Model *m,
-                    ObjTypes ot) : appearance_timestamp {ap_ts},
-                                   coords {c},
-                                   model {m},
-                                   obj_type {ot},
-                                   real_coords {glm::vec3()}
-                                   {};
-};
-
-struct AsteroidFragmentAttributes
-{
-    float appearance_timestamp;
-    glm::vec3 coords;
-    glm::vec3 direction;
-};
-
-struct StarShipAttributes
-{
-    float appearance_timestamp;
-    float last_shot_timestamp;
-    glm::vec3 coords;
-    Model *model;
-    ObjTypes obj_type;
-    glm::vec3 real_coords;
-
-    StarShipAttributes(float ap_ts,
-                       float lst,
-                       glm::vec3 c,
-                       Model *m,
-                       ObjTypes ot) : appearance_timestamp {ap_ts},
-                                      last_shot_timestamp {lst},
-                                      coords {c},
-                                      model {m},
-                                      obj_type {ot},
-                                      real_coords {glm::vec3()}
-                                      {};
-};
-
-struct Character
-{
-    GLuint TextureID;
-    glm::ivec2 Size;
-    glm::ivec2 Bearing;
-    GLuint Advance;
-};
+static const float FAR_PLANE = 100.0f;
 
 // Utility variables.
-std::map<GLchar, Character> Characters;
-GLuint VAO;
-GLuint VBO;
-
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = (float) WIDTH / 2.0;
 float lastY = (float) HEIGHT / 2.0;
@@ -116,13 +65,8 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 float current_frame = 0.0f;
-int score = 0;
-int health = 100;
-bool game_over = false;
-float key_a_timestamp = 0.0f;
-float key_d_timestamp = 0.0f;
-std::string large_explosion = "../resources/sounds/large_explosion.mp3";
-std::string game_name = "SMIERTIELNAJA BITWA";
+const char *large_explosion = "../resources/sounds/large_explosion.mp3";
+const char *game_name = "SMIERTIELNAJA BITWA";
 
 ShaderProgram program;
 ShaderProgram model_program;
@@ -130,38 +74,129 @@ ShaderProgram skybox_program;
 ShaderProgram text_program;
 ShaderProgram plasm_ball_program;
 ShaderProgram explosion_program;
+ShaderProgram dust_update_program;
+ShaderProgram debris_update_program;
+ShaderProgram dust_particle_program;
+ShaderProgram debris_particle_program;
+
+// Uniforms set during the frame, resolved once the programs are linked.
+UniformHandle<glm::mat4> model_uniform;
+
+// Per-frame model matrices of the instanced entity classes.
+InstanceBuffer plasm_ball_instances;
+InstanceBuffer explosion_instances;
+
+// Dust and asteroid debris, simulated and drawn on the GPU.
+ParticleSystem dust_particles;
+ParticleSystem debris_particles;
+
+// Simulation time the particles were last stepped to.
+float particle_time = 0.0f;
+
+// Debris bursts seen so far, and those overwritten in the ring before a
+// frame showed them, whose debris never appeared.
+unsigned int particle_bursts_seen = 0;
+unsigned long debris_bursts_dropped = 0;
+
+UniformHandle<float> dust_dt_uniform;
+UniformHandle<float> debris_dt_uniform;
+UniformHandle<glm::vec4> debris_bursts_uniform;
+UniformHandle<float> dust_pixel_scale_uniform;
+UniformHandle<float> debris_pixel_scale_uniform;
+
+FrameConstantsBuffer frame_constants;
+RenderQueue render_queue;
+
+// HUD font, and the frame's HUD text drawn from it in one call.
+GlyphAtlas glyph_atlas;
+TextBatch text_batch;
+
+// View frustum of the frame being drawn, and how many world objects it has
+// let through and culled so far.
+Frustum view_frustum;
+unsigned int objects_drawn = 0;
+unsigned int objects_culled = 0;
+
+// Objects whose bounding sphere covers a radius of fewer than LOD_PIXELS[i]
+// pixels on screen are drawn at level of detail i + 1 or coarser.
+static const float LOD_PIXELS[Mesh::MAX_LODS - 1] = {64.0f, 16.0f, 4.0f};
+
+// Camera position of the frame being drawn, and the on-screen size in
+// pixels of one unit at a distance of one unit.
+glm::vec3 view_position;
+float lod_pixel_scale = 1.0f;
+
+// Instances in view and their levels of detail, before they are grouped.
+std::vector<glm::mat4> visible_transforms;
+std::vector<unsigned char> visible_lods;
 
 unsigned int cubemapTexture;
 unsigned int skyboxVAO;
 GLuint scope_texture;
-Model sphere_model;
 ISoundEngine *sound_engine;
 
-std::vector<StarShipAttributes> starship_attributes;
-std::vector<ModelAttributes> plasm_ball_attributes;
-std::vector<ModelAttributes> enemy_plasm_ball_attributes;
-std::vector<ModelAttributes> explosion_attributes;
-std::vector<ModelAttributes> dust_attributes;
-std::vector<ModelAttributes> asteroid_attributes;
-std::vector<AsteroidFragmentAttributes> asteroid_fragment_attributes;
-
-
-void play_sound(std::string path, bool is_bg)
+Simulation simulation;
+Model *models[MODEL_COUNT];
+
+// Quad that plasm balls and explosions are drawn on as sphere impostors.
+Model *impostor_quad;
+
+// The main thread handles input, steps the simulation and publishes a
+// snapshot of every frame. The render thread owns the GL context and draws
+// the latest snapshot. The main thread only waits until its snapshot has
+// been taken, so it simulates frame N + 1 while frame N is being drawn.
+TripleBuffer<FrameSnapshot> snapshots;
+std::mutex frame_mutex;
+std::condition_variable frame_handoff;
+unsigned long frames_published = 0;
+unsigned long frames_taken = 0;
+bool render_running = true;
+
+// GL state changes of the last frame drawn, in the order its draws were
+// submitted and in the sorted order they were issued in.
+StateChanges submitted_changes = StateChanges();
+StateChanges executed_changes = StateChanges();
+
+// World objects of the last frame drawn that were in view and culled, and
+// the triangles drawn and that would have been drawn at full detail.
+unsigned int last_objects_drawn = 0;
+unsigned int last_objects_culled = 0;
+unsigned long last_triangles = 0;
+unsigned long last_full_triangles = 0;
+
+// debris_bursts_dropped as of the last frame drawn.
+unsigned long last_debris_bursts_dropped = 0;
+
+// Set by the framebuffer callback, applied by the render thread.
+int framebuffer_width = WIDTH;
+int framebuffer_height = HEIGHT;
+
+// Input gathered since the last tick. With --record every tick's input is
+// kept and written out on exit; with --replay input comes from a recording
+// instead and the live devices are ignored.
+TickInput pending_input = TickInput();
+InputRecording recording;
+const char *record_path = nullptr;
+bool replaying = false;
+unsigned long replay_tick = 0;
+
+
+void play_sound(const char *path, bool is_bg)
 {
     if (not sound_engine) {
         std::cerr << "irrKlang: Error starting up the sound engine";
     
     } else if (is_bg) {
-        sound_engine->play2D(path.c_str(), true);
+        sound_engine->play2D(path, true);
     
     } else {
-        irrklang::ISound *snd = sound_engine->play2D(path.c_str(),
+        irrklang::ISound *snd = sound_engine->play2D(path,
                                                      false,
                                                      false,
                                                      true);
         
         if (snd) {
-            if (path != large_explosion) {
+            if (std::strcmp(path, large_explosion) != 0) {
                 snd->setVolume(0.6);
             }
             snd->setIsPaused(false);
@@ -171,34 +206,54 @@ void play_sound(std::string path, bool is_bg)
     }
 }
 
+void play_sound_cues()
+{
+    for (auto cue: simulation.sounds) {
+        switch (cue) {
+        case SOUND_SHOT:
+            play_sound("../resources/sounds/shot_sound.mp3", false);
+            break;
+
+        case SOUND_EXPLOSION:
+            play_sound("../resources/sounds/explosion.wav", false);
+            break;
+
+        case SOUND_ENEMY_HIT:
+            play_sound("../resources/sounds/enemy_hit.mp3", false);
+            break;
+
+        case SOUND_LARGE_EXPLOSION:
+            play_sound(large_explosion, false);
+            break;
+        }
+    }
+
+    simulation.sounds.clear();
+}
+
 void processInput(GLFWwindow *window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     }
 
+    if (replaying) {
+        return;
+    }
+
     if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-        if ((current_frame - key_a_timestamp) > 0.15f and
-                camera.Position.x >= 0) {
-            
-            camera.Position.x -= 15.0f;
-            key_a_timestamp = current_frame;
-        }
+        pending_input.flags |= INPUT_MOVE_LEFT;
     }
 
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-        if ((current_frame - key_d_timestamp) > 0.15f
-                and camera.Position.x <= 0) {
-            
-            camera.Position.x += 15.0f;
-            key_d_timestamp = current_frame;
-        }
+        pending_input.flags |= INPUT_MOVE_RIGHT;
     }
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    framebuffer_width = width;
+    framebuffer_height = height;
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -216,7 +271,15 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     lastX = xpos;
     lastY = ypos;
 
+    if (replaying) {
+        return;
+    }
+
     camera.ProcessMouseMovement(xoffset, yoffset);
+
+    pending_input.flags |= INPUT_LOOK;
+    pending_input.look_x += xoffset;
+    pending_input.look_y += yoffset;
 }
 
 void mouse_button_callback(GLFWwindow* window,
@@ -224,25 +287,38 @@ void mouse_button_callback(GLFWwindow* window,
                            int action,
                            int mods)
 {
-    if (button == GLFW_MOUSE_BUTTON_RIGHT and
-            action == GLFW_PRESS and
-            not game_over) {
-        
-        plasm_ball_attributes.push_back(ModelAttributes(
-            current_frame,
-            glm::vec3(
-                camera.Front.x,
-                camera.Front.y,
-                camera.Front.z
-            ),
-            &sphere_model,
-            PLASM_BALL
-        ));
-
-        play_sound("../resources/sounds/shot_sound.mp3",
-                   false);
-    
+    if (button == GLFW_MOUSE_BUTTON_RIGHT and action == GLFW_PRESS and
+            not replaying) {
+
+        pending_input.flags |= INPUT_FIRE;
+        pending_input.fire_direction = camera.Front;
+    }
+}
+
+// Feeds one tick's input, live or recorded, to the simulation and steps it.
+void step_simulation(float dt)
+{
+    TickInput input;
+
+    if (replaying) {
+        input = recording.ticks[replay_tick++];
+
+        // Live, the camera has already followed the mouse.
+        if (input.flags & INPUT_LOOK) {
+            camera.ProcessMouseMovement(input.look_x, input.look_y);
+        }
+
+    } else {
+        input = pending_input;
+        pending_input = TickInput();
+
+        if (record_path != nullptr) {
+            recording.ticks.push_back(input);
+        }
     }
+
+    simulation.apply(input);
+    simulation.step(dt);
 }
 
 unsigned int loadCubemap(std::vector<std::string> faces)
@@ -345,33 +421,71 @@ unsigned int loadTexture(char const *path)
     return textureID;
 }
 
-void draw_starship(StarShipAttributes &attrs)
+// Whether model placed by model_matrix may be in view, and if so which
+// level of detail its size on screen calls for. Culled objects are only
+// left out of the frame; the simulation goes on moving them.
+bool in_view(const Model &model,
+             const glm::mat4 &model_matrix,
+             unsigned int &lod)
 {
-    attrs.real_coords = glm::vec3(
-            attrs.coords.x,
-            attrs.coords.y,
-            -100.0f + 20 * (current_frame - attrs.appearance_timestamp));
+    float scale = std::max(std::max(glm::length(glm::vec3(model_matrix[0])),
+                                    glm::length(glm::vec3(model_matrix[1]))),
+                           glm::length(glm::vec3(model_matrix[2])));
 
-    model_program.StartUseShader();
-    
-    glm::mat4 projection = glm::perspective(
-            glm::radians(camera.Zoom),
-            (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f);
-    
-    glm::mat4 view = camera.GetViewMatrix();
-    
-    model_program.SetUniform("view", view);
-    model_program.SetUniform("projection", projection);
+    glm::vec3 center = glm::vec3(model_matrix *
+                                 glm::vec4(model.boundsCenter, 1.0f));
+    float radius = model.boundsRadius * scale;
+
+    if (not view_frustum.intersects_sphere(center, radius)) {
+        objects_culled++;
+        return false;
+    }
+
+    objects_drawn++;
+
+    float distance = std::max(glm::distance(center, view_position), 0.1f);
+    float pixels = radius * lod_pixel_scale / distance;
 
+    lod = 0;
+    while (lod + 1 < Mesh::MAX_LODS and pixels < LOD_PIXELS[lod]) {
+        lod++;
+    }
+
+    return true;
+}
+
+// Submits every mesh of model to the opaque pass, placed by model_matrix,
+// if it is in view.
+void queue_model(const Model &model, const glm::mat4 &model_matrix)
+{
+    unsigned int lod;
+
+    if (not in_view(model, model_matrix, lod)) {
+        return;
+    }
+
+    for (auto &mesh: model.meshes) {
+        render_queue.submit(RENDER_PASS_OPAQUE,
+                            model_program,
+                            model_uniform,
+                            mesh,
+                            model_matrix,
+                            lod);
+    }
+}
+
+void queue_starship(const SnapshotEntity &ship)
+{
     glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, attrs.real_coords);
+    model_matrix = glm::translate(model_matrix,
+                                  ship.position);
 
-    if (attrs.obj_type != WRAITH) {
+    if (ship.obj_type != WRAITH) {
         model_matrix = glm::rotate(model_matrix,
                                    (float) M_PI,
                                    glm::vec3(0.0f, 1.0f, 0.0f));
 
-        if (attrs.obj_type == VULCAN) {
+        if (ship.obj_type == VULCAN) {
             model_matrix = glm::scale(model_matrix, glm::vec3(2.0f,
                                                               2.0f,
                                                               2.0f));
@@ -383,34 +497,20 @@ void draw_starship(StarShipAttributes &attrs)
                                                           0.01f));
     }
 
-    model_program.SetUniform("model", model_matrix);
-    attrs.model->Draw(model_program);
+    queue_model(*models[ship.model], model_matrix);
 }
 
-void draw_asteroid(ModelAttributes &attrs)
+void queue_asteroid(const SnapshotEntity &asteroid)
 {
-    attrs.real_coords = glm::vec3(
-            attrs.coords.x,
-            attrs.coords.y,
-            -110.0f + 30 * (current_frame - attrs.appearance_timestamp));
-
-    model_program.StartUseShader();
-    
-    glm::mat4 projection = glm::perspective(
-            glm::radians(camera.Zoom),
-            (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f);
-    
-    glm::mat4 view = camera.GetViewMatrix();
-    
-    model_program.SetUniform("view", view);
-    model_program.SetUniform("projection", projection);
+    float t = asteroid.age;
 
     glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, attrs.real_coords);
+    model_matrix = glm::translate(model_matrix,
+                                  asteroid.position);
 
-    if (attrs.obj_type == ASTEROID1) {
+    if (asteroid.obj_type == ASTEROID1) {
         model_matrix = glm::rotate(model_matrix,
-                (current_frame - attrs.appearance_timestamp),
+                t,
                 glm::vec3(0.0f, 1.0f, 0.0f));
 
         model_matrix = glm::scale(model_matrix, glm::vec3(2.0f,
@@ -419,7 +519,7 @@ void draw_asteroid(ModelAttributes &attrs)
 
     } else {
         model_matrix = glm::rotate(model_matrix,
-                4 *(current_frame - attrs.appearance_timestamp),
+                4 *t,
                 glm::vec3(1.0f, 1.0f, 0.0f));
     
         model_matrix = glm::scale(model_matrix, glm::vec3(0.05f,
@@ -427,165 +527,293 @@ void draw_asteroid(ModelAttributes &attrs)
                                                           0.05f));
     }
 
-    model_program.SetUniform("model", model_matrix);
-    attrs.model->Draw(model_program);
+    queue_model(*models[asteroid.model], model_matrix);
 }
 
-void draw_asteroid_fragment(Model &model, AsteroidFragmentAttributes &attrs)
+// Instanced classes: every entity of a class goes into one draw per mesh,
+// with its model matrix taken from the class's instance buffer.
+
+void queue_instances(const ShaderProgram &program,
+                     const Model &model,
+                     InstanceBuffer &instances)
 {
-    glm::vec3 real_coords(
-            attrs.coords.x + 100 * attrs.direction.x *
-                    (current_frame - attrs.appearance_timestamp),
-            attrs.coords.y + 100 * attrs.direction.y *
-                    (current_frame - attrs.appearance_timestamp),
-            attrs.coords.z + 100 * attrs.direction.z *
-                    (current_frame - attrs.appearance_timestamp));
-
-    model_program.StartUseShader();
-
-    glm::mat4 projection = glm::perspective(
-            glm::radians(camera.Zoom),
-            (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f);
-    
-    glm::mat4 view = camera.GetViewMatrix();
-    
-    model_program.SetUniform("view", view);
-    model_program.SetUniform("projection", projection);
+    std::vector<glm::mat4> &transforms = instances.transforms;
 
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, real_coords);
+    visible_transforms.clear();
+    visible_lods.clear();
 
-    model_matrix = glm::rotate(model_matrix,
-            (current_frame - attrs.appearance_timestamp),
-            glm::vec3(0.0f, 1.0f, 0.0f));
+    unsigned int lod_count[Mesh::MAX_LODS] = {};
 
-    model_matrix = glm::scale(model_matrix, glm::vec3(0.025f,
-                                                      0.025f,
-                                                      0.025f));
+    // Levels past the model's last would draw its last level again, as
+    // a group of their own.
+    unsigned int levels = 1;
 
-    model_program.SetUniform("model", model_matrix);
-    model.Draw(model_program);
-}
+    for (auto &mesh: model.meshes) {
+        levels = std::max(levels, (unsigned int) mesh.lods.size());
+    }
 
-void draw_plasm_ball(Model &model, ModelAttributes &attrs)
-{
-    attrs.real_coords = glm::vec3(
-            camera.Position.x + 200 * attrs.coords.x *
-                (current_frame - attrs.appearance_timestamp),
-            200 * attrs.coords.y *
-                (current_frame - attrs.appearance_timestamp),
-            150 * attrs.coords.z / abs(attrs.coords.z) *
-                (current_frame - attrs.appearance_timestamp));
+    for (auto &transform: transforms) {
+        unsigned int lod;
 
-    plasm_ball_program.StartUseShader();
+        if (in_view(model, transform, lod)) {
+            lod = std::min(lod, levels - 1);
+            visible_transforms.push_back(transform);
+            visible_lods.push_back(lod);
+            lod_count[lod]++;
+        }
+    }
 
-    glm::mat4 projection = glm::perspective(
-            glm::radians(camera.Zoom),
-            (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f);
+    // Group the visible instances by level of detail, each group being
+    // one draw per mesh.
+    unsigned int lod_first[Mesh::MAX_LODS];
+    unsigned int next[Mesh::MAX_LODS];
+    unsigned int first = 0;
 
-    glm::mat4 view = camera.GetViewMatrix();
+    for (unsigned int lod = 0; lod < Mesh::MAX_LODS; lod++) {
+        lod_first[lod] = first;
+        next[lod] = first;
+        first += lod_count[lod];
+    }
 
-    plasm_ball_program.SetUniform("view", view);
-    plasm_ball_program.SetUniform("projection", projection);
+    transforms.resize(visible_transforms.size());
 
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, attrs.real_coords);
+    for (unsigned int i = 0; i < visible_transforms.size(); i++) {
+        transforms[next[visible_lods[i]]++] = visible_transforms[i];
+    }
 
-    model_matrix = glm::scale(model_matrix, glm::vec3(0.005f,
-                                                      0.005f,
-                                                      0.005f));
+    if (instances.count() == 0) {
+        return;
+    }
 
-    plasm_ball_program.SetUniform("model", model_matrix);
-    model.Draw(plasm_ball_program);
+    instances.upload();
+
+    for (unsigned int lod = 0; lod < Mesh::MAX_LODS; lod++) {
+        for (auto &mesh: model.meshes) {
+            render_queue.submit_instanced(RENDER_PASS_OPAQUE,
+                                          program,
+                                          mesh,
+                                          instances,
+                                          lod_first[lod],
+                                          lod_count[lod],
+                                          lod);
+        }
+    }
 }
 
-void draw_enemy_plasm_ball(Model &model, ModelAttributes &attrs)
+// A quad from (-1, -1) to (1, 1), bounded by the unit sphere as far as
+// culling and level of detail are concerned.
+void build_impostor_quad(Model &quad)
 {
-    attrs.real_coords = glm::vec3(
-            attrs.coords.x - 2 * (attrs.coords.x - camera.Position.x) *
-                (current_frame - attrs.appearance_timestamp),
+    std::vector<Vertex> vertices(4);
+    const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
 
-            attrs.coords.y - 2 * attrs.coords.y *
-                (current_frame - attrs.appearance_timestamp),
+    for (unsigned int i = 0; i < 4; i++) {
+        vertices[i] = Vertex();
+        vertices[i].Position = glm::vec3(corners[i][0], corners[i][1], 0.0f);
+        vertices[i].Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
 
-            attrs.coords.z - 2 * (attrs.coords.z - 3.0f) *
-                (current_frame - attrs.appearance_timestamp));
+    std::vector<unsigned int> indices = {0, 1, 2, 0, 2, 3};
 
-    plasm_ball_program.StartUseShader();
+    quad.meshes.push_back(Mesh(vertices, indices, std::vector<Texture>()));
+    quad.boundsCenter = glm::vec3(0.0f);
+    quad.boundsRadius = 1.0f;
+}
 
-    glm::mat4 projection = glm::perspective(
-            glm::radians(camera.Zoom),
-            (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f);
-    
-    glm::mat4 view = camera.GetViewMatrix();
-    
-    plasm_ball_program.SetUniform("view", view);
-    plasm_ball_program.SetUniform("projection", projection);
+// Plasm balls and explosions look like plain spheres, so rather than the
+// sphere model they draw a quad each, on which the impostor shader
+// ray-traces the sphere. The instance matrix carries the centre and, as its
+// scale, the radius of the sphere model instance it stands for.
+glm::mat4 sphere_impostor(const glm::vec3 &position, float scale)
+{
+    const Model &sphere = *models[SPHERE_MODEL];
 
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, attrs.real_coords);
+    glm::mat4 model_matrix = glm::translate(
+            glm::mat4(1.0f),
+            position + scale * sphere.boundsCenter);
+
+    return glm::scale(model_matrix, glm::vec3(scale * sphere.boundsRadius));
+}
 
-    model_matrix = glm::scale(model_matrix, glm::vec3(0.005f,
-                                                      0.005f,
-                                                      0.005f));
+// Player and enemy fire look the same, so they share one draw.
+void queue_plasm_balls(const FrameSnapshot &frame)
+{
+    std::vector<glm::mat4> &transforms = plasm_ball_instances.transforms;
+    transforms.clear();
 
-    plasm_ball_program.SetUniform("model", model_matrix);
-    model.Draw(plasm_ball_program);
+    for (auto balls: {&frame.plasm_balls, &frame.enemy_plasm_balls}) {
+        for (auto &plasm_ball: *balls) {
+            transforms.push_back(sphere_impostor(plasm_ball.position,
+                                                 0.005f));
+        }
+    }
+
+    queue_instances(plasm_ball_program,
+                    *impostor_quad,
+                    plasm_ball_instances);
 }
 
-void draw_exploison(Model &model, ModelAttributes &attrs)
+void queue_explosions(const FrameSnapshot &frame)
 {
-    explosion_program.StartUseShader();
+    std::vector<glm::mat4> &transforms = explosion_instances.transforms;
+    transforms.resize(frame.explosions.size());
 
-    glm::mat4 projection = glm::perspective(
-            glm::radians(camera.Zoom),
-            (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f);
-    
-    glm::mat4 view = camera.GetViewMatrix();
-    
-    explosion_program.SetUniform("view", view);
-    explosion_program.SetUniform("projection", projection);
+    for (unsigned int i = 0; i < transforms.size(); i++) {
+        const SnapshotEntity &explosion = frame.explosions[i];
 
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, attrs.coords);
+        transforms[i] = sphere_impostor(explosion.position,
+                                        0.1f * explosion.age);
+    }
 
-    model_matrix =
-            glm::scale(model_matrix,
-            glm::vec3(0.1f * (current_frame - attrs.appearance_timestamp),
-                      0.1f * (current_frame - attrs.appearance_timestamp),
-                      0.1f * (current_frame - attrs.appearance_timestamp)));
+    queue_instances(explosion_program,
+                    *impostor_quad,
+                    explosion_instances);
+}
+
+// Dust specks fly from z = -100 towards the camera, as the old CPU ones
+// did; every shattered asteroid throws out DEBRIS_PER_BURST particles.
+static const float DUST_SIZE = 0.08f;
+static const float DUST_SPEED = 100.0f;
+static const float DEBRIS_SIZE = 0.05f;
+static const float DEBRIS_SPEED = 100.0f;
+static const unsigned int DEBRIS_PER_BURST = 1024;
+
+// Allocates the particle pools and sets the emitter uniforms, which the
+// scenario decides: as many specks as its dust rate keeps alive, and the
+// dust and fragment lifetimes.
+void create_particles(const Scenario &scenario)
+{
+    float dust_lifetime = scenario.lifetimes[DUST];
+    float dust_rate = scenario.dust_burst /
+                      std::max(scenario.dust_interval, SIM_TICK);
 
-    explosion_program.SetUniform("model", model_matrix);
-    model.Draw(explosion_program);
+    unsigned int specks = (unsigned int) std::ceil(dust_rate * dust_lifetime);
+
+    // Specks are born one after another over the first lifetime.
+    std::vector<Particle> particles(specks);
+
+    for (unsigned int i = 0; i < specks; i++) {
+        particles[i] = Particle();
+        particles[i].lifetime = dust_lifetime * (i + 1) / specks;
+        particles[i].generation = -1.0f;
+    }
+
+    dust_particles.create(particles);
+
+    // Debris waits for a burst in its slot.
+    particles.assign(DEBRIS_BURSTS * DEBRIS_PER_BURST, Particle());
+
+    for (auto &particle: particles) {
+        particle.generation = -1.0f;
+    }
+
+    debris_particles.create(particles);
+
+    dust_update_program.StartUseShader();
+    dust_update_program.SetUniform(
+            dust_update_program.GetUniform<float>("spread"),
+            (float) scenario.spawn_spread);
+    dust_update_program.SetUniform(
+            dust_update_program.GetUniform<float>("spawnDepth"),
+            -100.0f);
+    dust_update_program.SetUniform(
+            dust_update_program.GetUniform<float>("speed"),
+            DUST_SPEED);
+    dust_update_program.SetUniform(
+            dust_update_program.GetUniform<float>("speckLifetime"),
+            dust_lifetime);
+
+    debris_update_program.StartUseShader();
+    debris_update_program.SetUniform(
+            debris_update_program.GetUniform<int>("particlesPerBurst"),
+            (int) DEBRIS_PER_BURST);
+    debris_update_program.SetUniform(
+            debris_update_program.GetUniform<float>("speed"),
+            DEBRIS_SPEED);
+    debris_update_program.SetUniform(
+            debris_update_program.GetUniform<float>("debrisLifetime"),
+            scenario.lifetimes[ASTEROID_FRAGMENT]);
+
+    dust_particle_program.StartUseShader();
+    dust_particle_program.SetUniform(
+            dust_particle_program.GetUniform<float>("size"),
+            DUST_SIZE);
+    dust_particle_program.SetUniform(
+            dust_particle_program.GetUniform<float>("fading"),
+            0.0f);
+    dust_particle_program.SetUniform(
+            dust_particle_program.GetUniform<glm::vec3>("color"),
+            glm::vec3(1.0f, 1.0f, 1.0f));
+
+    debris_particle_program.StartUseShader();
+    debris_particle_program.SetUniform(
+            debris_particle_program.GetUniform<float>("size"),
+            DEBRIS_SIZE);
+    debris_particle_program.SetUniform(
+            debris_particle_program.GetUniform<float>("fading"),
+            1.0f);
+    debris_particle_program.SetUniform(
+            debris_particle_program.GetUniform<glm::vec3>("color"),
+            glm::vec3(0.55f, 0.5f, 0.45f));
+
+    dust_dt_uniform = dust_update_program.GetUniform<float>("dt");
+    debris_dt_uniform = debris_update_program.GetUniform<float>("dt");
+    debris_bursts_uniform =
+            debris_update_program.GetUniform<glm::vec4>("bursts");
+    dust_pixel_scale_uniform =
+            dust_particle_program.GetUniform<float>("pixelScale");
+    debris_pixel_scale_uniform =
+            debris_particle_program.GetUniform<float>("pixelScale");
 }
 
-void draw_dust(Model &model, ModelAttributes &attrs)
+// Steps the particles to the time of frame. They follow simulation time,
+// so they stop when the game does.
+void update_particles(const FrameSnapshot &frame)
 {
-    attrs.real_coords = glm::vec3(
-            attrs.coords.x,
-            attrs.coords.y,
-            -100.0f + 100 * (current_frame - attrs.appearance_timestamp));
+    float dt = std::min(std::max(frame.time - particle_time, 0.0f), 0.25f);
+    particle_time = frame.time;
 
-    plasm_ball_program.StartUseShader();
+    unsigned int new_bursts = frame.debris_burst_count - particle_bursts_seen;
+    if (new_bursts > DEBRIS_BURSTS) {
+        debris_bursts_dropped += new_bursts - DEBRIS_BURSTS;
+    }
+    particle_bursts_seen = frame.debris_burst_count;
 
-    glm::mat4 projection = glm::perspective(
-            glm::radians(camera.Zoom),
-            (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f);
+    dust_update_program.StartUseShader();
+    dust_update_program.SetUniform(dust_dt_uniform, dt);
+    dust_particles.update();
 
-    glm::mat4 view = camera.GetViewMatrix();
-  
-    plasm_ball_program.SetUniform("view", view);
-    plasm_ball_program.SetUniform("projection", projection);
+    glm::vec4 bursts[DEBRIS_BURSTS];
 
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, attrs.real_coords);
+    for (unsigned int k = 0; k < DEBRIS_BURSTS; k++) {
+        bursts[k] = glm::vec4(frame.debris_bursts[k].position,
+                              frame.debris_bursts[k].time);
+    }
 
-    model_matrix = glm::scale(model_matrix, glm::vec3(0.04f,
-                                                      0.04f,
-                                                      0.04f));
+    debris_update_program.StartUseShader();
+    debris_update_program.SetUniform(debris_dt_uniform, dt);
+    debris_update_program.SetUniform(debris_bursts_uniform,
+                                     bursts,
+                                     DEBRIS_BURSTS);
+    debris_particles.update();
+}
 
-    plasm_ball_program.SetUniform("model", model_matrix);
-    model.Draw(plasm_ball_program);
+// Particles blend over the scene without hiding each other.
+void draw_particles()
+{
+    glDepthMask(GL_FALSE);
+
+    dust_particle_program.StartUseShader();
+    dust_particle_program.SetUniform(dust_pixel_scale_uniform,
+                                     lod_pixel_scale);
+    dust_particles.draw();
+
+    debris_particle_program.StartUseShader();
+    debris_particle_program.SetUniform(debris_pixel_scale_uniform,
+                                       lod_pixel_scale);
+    debris_particles.draw();
+
+    glDepthMask(GL_TRUE);
 }
 
 void draw_skybox()
@@ -593,14 +821,6 @@ void draw_skybox()
     glDepthFunc(GL_LEQUAL);
 
     skybox_program.StartUseShader();
-    
-    glm::mat4 view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
-    glm::mat4 projection = glm::perspective(
-            glm::radians(camera.Zoom),
-            (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f);
-
-    skybox_program.SetUniform("view", view);
-    skybox_program.SetUniform("projection", projection);
 
     glBindVertexArray(skyboxVAO);
     glActiveTexture(GL_TEXTURE0);
@@ -610,8 +830,9 @@ void draw_skybox()
     glDepthFunc(GL_LESS);
 }
 
-void RenderText(ShaderProgram &program,
-                std::string text,
+// Adds text to the frame's HUD batch. Positions and scale are given for a
+// STANDART_TEXT_WIDTH wide window; scale 1 is an em of HUD_FONT_SIZE.
+void RenderText(const char *text,
                 GLfloat x,
                 GLfloat y,
                 GLfloat scale,
@@ -620,119 +841,8 @@ void RenderText(ShaderProgram &program,
     x /= (float) STANDART_TEXT_WIDTH / WIDTH;
     y /= (float) STANDART_TEXT_WIDTH / WIDTH;
     scale /= (float) STANDART_TEXT_WIDTH / WIDTH;
-  
-    program.StartUseShader();
-    glUniform3f(glGetUniformLocation(program.GetProgram(), "textColor"),
-                color.x,
-                color.y,
-                color.z);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(VAO);
 
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++) 
-    {
-        Character ch = Characters[*c];
-
-        GLfloat xpos = x + ch.Bearing.x * scale;
-        GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
-
-        GLfloat w = ch.Size.x * scale;
-        GLfloat h = ch.Size.y * scale;
-        
-        GLfloat vertices[6][4] = {
-            { xpos,     ypos + h,   0.0, 0.0 },            
-            { xpos,     ypos,       0.0, 1.0 },
-            { xpos + w, ypos,       1.0, 1.0 },
-
-            { xpos,     ypos + h,   0.0, 0.0 },
-            { xpos + w, ypos,       1.0, 1.0 },
-            { xpos + w, ypos + h,   1.0, 0.0 }           
-        };
-        
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        
-        x += (ch.Advance >> 6) * scale;
-    }
-
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-}
-
-void clear_objects()
-{
-    for (auto &it: starship_attributes) {
-        if (current_frame - it.appearance_timestamp > 10) {
-            starship_attributes.erase(starship_attributes.begin());
-        
-        } else {
-            break;
-        }
-    }
-
-    for (auto &it: plasm_ball_attributes) {
-        if (current_frame - it.appearance_timestamp > 1) {
-            plasm_ball_attributes.erase(plasm_ball_attributes.begin());
-        
-        } else {
-            break;
-        }
-    }
-
-    for (auto &it: enemy_plasm_ball_attributes) {
-        if (current_frame - it.appearance_timestamp > 1) {
-            enemy_plasm_ball_attributes.erase(
-                    enemy_plasm_ball_attributes.begin());
-        
-        } else {
-            break;
-        }
-    }
-
-    for (auto &it: explosion_attributes) {
-        if (current_frame - it.appearance_timestamp > 0.3) {
-            explosion_attributes.erase(explosion_attributes.begin());
-        
-        } else {
-            break;
-        }
-    }
-
-    for (auto &it: dust_attributes) {
-        if (current_frame - it.appearance_timestamp > 1) {
-            dust_attributes.erase(dust_attributes.begin());
-        
-        } else {
-            break;
-        }
-    }
-
-    for (auto &it: asteroid_attributes) {
-        if (current_frame - it.appearance_timestamp > 10) {
-            asteroid_attributes.erase(asteroid_attributes.begin());
-        
-        } else {
-            break;
-        }
-    }
-
-    for (auto &it: asteroid_fragment_attributes) {
-        if (current_frame - it.appearance_timestamp > 0.3) {
-            asteroid_fragment_attributes.erase(
-                    asteroid_fragment_attributes.begin());
-        
-        } else {
-            break;
-        }
-    }
+    text_batch.add(glyph_atlas, text, x, y, HUD_FONT_SIZE * scale, color);
 }
 
 int initGL()
@@ -760,37 +870,166 @@ int initGL()
 }
 
 
-int main(int argc, char** argv)
+// Tells the main thread that no more frames will be drawn.
+void stop_rendering()
 {
-	if (!glfwInit()) {
-        return -1;
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex);
+        render_running = false;
     }
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); 
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); 
-	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE); 
+    frame_handoff.notify_all();
+}
 
-    GLFWwindow*  window = glfwCreateWindow(WIDTH,
-                                           HEIGHT,
-                                           game_name.c_str(),
-                                           nullptr,
-                                           nullptr);
+void draw_hud(const FrameSnapshot &frame)
+{
+    // HUD lines are formatted here rather than into fresh strings.
+    char hud_text[64];
 
-	if (window == nullptr) {
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-	
-	glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetMouseButtonCallback(window, mouse_button_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    glyph_atlas.begin_frame();
+    text_batch.clear();
+
+    if (frame.game_over) {
+        RenderText("Your soul has been taken by the Space",
+                   369.0f,
+                   505.0f,
+                   0.5f,
+                   glm::vec3(1.0f, 1.0f, 1.0f));
+
+        RenderText("And you will know My name is the Lord",
+                   439.0f,
+                   415.0f,
+                   0.425f,
+                   glm::vec3(1.0f, 1.0f, 1.0f));
+
+        RenderText("    When I lay My vengeance upon thee",
+                   435.0f,
+                   392.0f,
+                   0.425f,
+                   glm::vec3(1.0f, 1.0f, 1.0f));
+
+        RenderText("                 OT: Ezekiel, XXV, 17",
+                   507.0f,
+                   369.0f,
+                   0.425f,
+                   glm::vec3(1.0f, 1.0f, 1.0f));
+
+        std::snprintf(hud_text,
+                      sizeof(hud_text),
+                      "Exit in %d",
+                      OUTRO_TIMEOUT - (int) frame.game_over_elapsed);
+
+        RenderText(hud_text,
+                   506.0f,
+                   279.0f,
+                   0.665f,
+                   glm::vec3(1.0f, 1.0f, 1.0f));
+
+    } else {
+        RenderText("+",
+                   555.0f,
+                   415.0f,
+                   0.5f,
+                   glm::vec3(1.0f, 1.0f, 1.0f));
+    }
+
+    std::snprintf(hud_text,
+                  sizeof(hud_text),
+                  "Total score: %d",
+                  frame.score);
+
+    RenderText(hud_text,
+               3.0f,
+               32,
+               0.5f,
+               glm::vec3(1.0f, 1.0f, 1.0f));
+
+    std::snprintf(hud_text,
+                  sizeof(hud_text),
+                  "Health: %d",
+                  frame.health);
+
+    RenderText(hud_text,
+               3.0f,
+               3.0f,
+               0.5f,
+               glm::vec3(1.0f, 1.0f, 1.0f));
+
+    text_program.StartUseShader();
+    text_batch.draw(glyph_atlas);
+}
+
+// Camera matrices for the whole frame, read by every 3D shader from the
+// FrameConstants block instead of being set per draw.
+FrameConstants frame_constants_of(const FrameSnapshot &frame)
+{
+    FrameConstants constants;
+
+    constants.view = frame.view;
+    constants.projection = glm::perspective(
+            glm::radians(frame.zoom),
+            (float) WIDTH / (float) HEIGHT, 0.1f, FAR_PLANE);
+    constants.view_projection = constants.projection * constants.view;
+    constants.camera_position = frame.camera_position;
+    constants.time = frame.time;
+
+    return constants;
+}
+
+void draw_frame(const FrameSnapshot &frame)
+{
+    FrameConstants constants = frame_constants_of(frame);
+    frame_constants.upload(constants);
+
+    view_frustum = Frustum(constants.view_projection);
+    view_position = frame.camera_position;
+    lod_pixel_scale = 0.5f * frame.framebuffer_height /
+                      std::tan(0.5f * glm::radians(frame.zoom));
+    objects_drawn = 0;
+    objects_culled = 0;
+
+    glClearColor(0.02f, 0.2f, 0.07f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    render_queue.begin(frame.camera_position, FAR_PLANE);
+
+    for (auto &ship: frame.starships) {
+        queue_starship(ship);
+    }
+
+    for (auto &asteroid: frame.asteroids) {
+        queue_asteroid(asteroid);
+    }
+
+    queue_plasm_balls(frame);
+    queue_explosions(frame);
+
+    render_queue.sort();
+
+    render_queue.execute(RENDER_PASS_OPAQUE);
+    draw_skybox();
+    render_queue.execute(RENDER_PASS_BLENDED);
+
+    update_particles(frame);
+    draw_particles();
+
+    draw_hud(frame);
+}
+
+// Body of the render thread: sets up GL on the window's context, with the
+// particle emitters as scenario says, then draws each snapshot the main
+// thread publishes until told to stop.
+void render_frames(GLFWwindow *window, bool vsync, const Scenario &scenario)
+{
+    glfwMakeContextCurrent(window);
+
+    if (not vsync) {
+        glfwSwapInterval(0);
+    }
 
 	if (initGL() != 0) {
-	   return -1;
+        stop_rendering();
+	    return;
     }
 
 	GLenum gl_error = glGetError();
@@ -800,11 +1039,9 @@ int main(int argc, char** argv)
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
+    glEnable(GL_PROGRAM_POINT_SIZE);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    sound_engine = createIrrKlangDevice();
-    play_sound("../resources/sounds/background_music.mp3", true);
-
     std::unordered_map<GLenum, std::string> skybox_shaders;
     skybox_shaders[GL_VERTEX_SHADER] = "skybox_vertex.glsl";
     skybox_shaders[GL_FRAGMENT_SHADER] = "skybox_fragment.glsl";
@@ -823,99 +1060,77 @@ int main(int argc, char** argv)
     text_program = ShaderProgram(text_shaders);
     GL_CHECK_ERRORS;
 
-    std::unordered_map<GLenum, std::string> plasm_ball_shaders;
-    plasm_ball_shaders[GL_VERTEX_SHADER] = "plasm_ball_vertex.glsl";
-    plasm_ball_shaders[GL_FRAGMENT_SHADER] = "plasm_ball_fragment.glsl";
-    plasm_ball_program = ShaderProgram(plasm_ball_shaders);
+    // Plasm balls and explosions share the impostor shaders and differ in
+    // colour only.
+    std::unordered_map<GLenum, std::string> impostor_shaders;
+    impostor_shaders[GL_VERTEX_SHADER] = "impostor_vertex.glsl";
+    impostor_shaders[GL_FRAGMENT_SHADER] = "impostor_fragment.glsl";
+    plasm_ball_program = ShaderProgram(impostor_shaders);
     GL_CHECK_ERRORS;
 
-    std::unordered_map<GLenum, std::string> explosion_shaders;
-    explosion_shaders[GL_VERTEX_SHADER] = "explosion_vertex.glsl";
-    explosion_shaders[GL_FRAGMENT_SHADER] = "explosion_fragment.glsl";
-    explosion_program = ShaderProgram(explosion_shaders);
+    explosion_program = ShaderProgram(impostor_shaders);
     GL_CHECK_ERRORS;
 
-    glm::mat4 projection = glm::ortho(0.0f,
-                                      static_cast<GLfloat>(WIDTH),
-                                      0.0f,
-                                      static_cast<GLfloat>(HEIGHT));
-    
-    text_program.StartUseShader();
-    glUniformMatrix4fv(
-            glGetUniformLocation(text_program.GetProgram(), "projection"),
-            1,
-            GL_FALSE,
-            glm::value_ptr(projection));
-
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library"
-                  << std::endl;
-    }
+    std::unordered_map<GLenum, std::string> dust_update_shaders;
+    dust_update_shaders[GL_VERTEX_SHADER] = "dust_update_vertex.glsl";
+    dust_update_program = ShaderProgram(dust_update_shaders);
+    dust_update_program.CaptureVaryings(ParticleSystem::varyings());
+    GL_CHECK_ERRORS;
 
-    FT_Face face;
-    if (FT_New_Face(ft, "../resources/fonts/arial.ttf", 0, &face)) {
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-    }
+    std::unordered_map<GLenum, std::string> debris_update_shaders;
+    debris_update_shaders[GL_VERTEX_SHADER] = "debris_update_vertex.glsl";
+    debris_update_program = ShaderProgram(
+            debris_update_shaders,
+            "#define DEBRIS_BURSTS " + std::to_string(DEBRIS_BURSTS) + "\n");
+    debris_update_program.CaptureVaryings(ParticleSystem::varyings());
+    GL_CHECK_ERRORS;
 
-    FT_Set_Pixel_Sizes(face, 0, 48);
+    // Dust and debris share the point shaders and differ in uniforms only.
+    std::unordered_map<GLenum, std::string> particle_shaders;
+    particle_shaders[GL_VERTEX_SHADER] = "particle_vertex.glsl";
+    particle_shaders[GL_FRAGMENT_SHADER] = "particle_fragment.glsl";
+    dust_particle_program = ShaderProgram(particle_shaders);
+    GL_CHECK_ERRORS;
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
+    debris_particle_program = ShaderProgram(particle_shaders);
+    GL_CHECK_ERRORS;
 
-    for (GLubyte c = 0; c < 128; c++)
-    {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-            continue;
-        }
-        
-        GLuint texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D,
-                     0,
-                     GL_RED,
-                     face->glyph->bitmap.width,
-                     face->glyph->bitmap.rows,
-                     0,
-                     GL_RED,
-                     GL_UNSIGNED_BYTE,
-                     face->glyph->bitmap.buffer
-        );
+    for (auto shader_program: {&skybox_program,
+                               &model_program,
+                               &plasm_ball_program,
+                               &explosion_program,
+                               &debris_update_program,
+                               &dust_particle_program,
+                               &debris_particle_program}) {
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        
-        Character character =
-        {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            (GLuint) face->glyph->advance.x
-        };
-        
-        Characters.insert(std::pair<GLchar, Character>(c, character));
+        shader_program->BindUniformBlock("FrameConstants",
+                                         FRAME_CONSTANTS_BINDING);
     }
+
+    plasm_ball_program.StartUseShader();
+    plasm_ball_program.SetUniform(
+            plasm_ball_program.GetUniform<glm::vec3>("color"),
+            glm::vec3(1.0f, 1.0f, 1.0f));
+
+    explosion_program.StartUseShader();
+    explosion_program.SetUniform(
+            explosion_program.GetUniform<glm::vec3>("color"),
+            glm::vec3(0.71f, 0.086f, 0.03f));
+
+    model_uniform = model_program.GetUniform<glm::mat4>("model");
+    create_particles(scenario);
+
+    glm::mat4 projection = glm::ortho(0.0f,
+                                      static_cast<GLfloat>(WIDTH),
+                                      0.0f,
+                                      static_cast<GLfloat>(HEIGHT));
     
-    glBindTexture(GL_TEXTURE_2D, 0);
-    
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
-    
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(GLfloat) * 6 * 4,
-                 NULL,
-                 GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    text_program.StartUseShader();
+    text_program.SetUniform(
+            text_program.GetUniform<glm::mat4>("projection"),
+            projection);
+
+    glyph_atlas.load("../resources/fonts/arial.ttf");
 
     float skybox_vertices[] =
     {
@@ -993,7 +1208,7 @@ int main(int argc, char** argv)
     cubemapTexture = loadCubemap(faces);
 
     skybox_program.StartUseShader();
-    skybox_program.SetUniform("skybox", 0);
+    skybox_program.SetUniform(skybox_program.GetUniform<int>("skybox"), 0);
 
     Model vulcan_starship_model(
             "../resources/objects/vulcan_starship/vulcan_starship.obj");
@@ -1004,499 +1219,404 @@ int main(int argc, char** argv)
     Model wraith_model(
             "../resources/objects/wraith/wraith.obj");
 
-    sphere_model = Model(
+    Model sphere_model(
             "../resources/objects/sphere/sphere.obj");
 
-    Model dust_model(
-            "../resources/objects/cube/cube.obj");
-
     Model asteroid_model1(
             "../resources/objects/asteroid1/asteroid1.obj");
 
     Model asteroid_model2(
             "../resources/objects/asteroid2/asteroid2.obj");
 
-    srand(time(0));
+    models[E45_MODEL] = &e45_model;
+    models[WRAITH_MODEL] = &wraith_model;
+    models[VULCAN_MODEL] = &vulcan_starship_model;
+    models[ASTEROID1_MODEL] = &asteroid_model1;
+    models[ASTEROID2_MODEL] = &asteroid_model2;
+    models[SPHERE_MODEL] = &sphere_model;
 
-    float prev_model_timestamp = 0.0f;
-    float prev_dust_timestamp = 0.0f;
-    float prev_asteroid_timestamp = 0.0f;
-    float game_over_timestamp = 0.0f;
-    int type_of_starship = 0;
-    int type_of_asteroid = 0;
+    Model impostor_model;
+    build_impostor_quad(impostor_model);
+    impostor_quad = &impostor_model;
 
-    // Render loop.
-    while (!glfwWindowShouldClose(window)) {
-        current_frame = glfwGetTime();
-        deltaTime = current_frame - lastFrame;
-        lastFrame = current_frame;
+    int viewport_width = WIDTH;
+    int viewport_height = HEIGHT;
 
-        processInput(window);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(frame_mutex);
 
-        glClearColor(0.02f, 0.2f, 0.07f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            frame_handoff.wait(lock, []() {
+                return frames_taken != frames_published or
+                       not render_running;
+            });
 
-        if (prev_model_timestamp == 0.0f) {
-            prev_model_timestamp = current_frame - 1.0f;
+            if (not render_running) {
+                break;
+            }
+
+            snapshots.acquire();
+            frames_taken = frames_published;
+
+            submitted_changes = render_queue.submitted_changes();
+            executed_changes = render_queue.executed_changes();
+            last_objects_drawn = objects_drawn;
+            last_objects_culled = objects_culled;
+            last_triangles = render_queue.triangles_drawn();
+            last_full_triangles = render_queue.full_detail_triangles();
+            last_debris_bursts_dropped = debris_bursts_dropped;
         }
 
-        // Add new starship.
-        if (current_frame - prev_model_timestamp > 2.0f) {
-            if (type_of_starship == 0 or type_of_starship == 2) {
-                starship_attributes.push_back(StarShipAttributes(
-                    current_frame,
-                    current_frame + 1.0f,
-                    glm::vec3(
-                        (float) -20 + rand() % 41,
-                        (float) -20 + rand() % 41,
-                        0.0f
-                    ),
-                    &e45_model,
-                    E45
-                ));
-            
-            } else if (type_of_starship == 1 or type_of_starship == 3) {
-                starship_attributes.push_back(StarShipAttributes(
-                    current_frame,
-                    current_frame + 1.0f,
-                    glm::vec3(
-                        (float) -20 + rand() % 41,
-                        (float) -20 + rand() % 41,
-                        0.0f
-                    ),
-                    &wraith_model,
-                    WRAITH
-                ));
-            
-            } else {
-                starship_attributes.push_back(StarShipAttributes(
-                    current_frame,
-                    current_frame + 1.0f,
-                    glm::vec3(
-                        (float) -20 + rand() % 41,
-                        (float) -20 + rand() % 41,
-                        0.0f
-                    ),
-                    &vulcan_starship_model,
-                    VULCAN
-                ));
-            }
+        frame_handoff.notify_all();
 
-            type_of_starship = (type_of_starship + 1) % 5;
-            prev_model_timestamp = current_frame;
+        const FrameSnapshot &frame = snapshots.front();
+
+        if (frame.framebuffer_width != viewport_width or
+                frame.framebuffer_height != viewport_height) {
+
+            viewport_width = frame.framebuffer_width;
+            viewport_height = frame.framebuffer_height;
+            glViewport(0, 0, viewport_width, viewport_height);
         }
 
-        // Add new asteroid.
-        if (current_frame - prev_asteroid_timestamp > 2.0f) {
-            if (type_of_asteroid == 0) {
-                asteroid_attributes.push_back(ModelAttributes(
-                    current_frame,
-                    glm::vec3(
-                        (float) -20 + rand() % 41,
-                        (float) -20 + rand() % 41,
-                        0.0f
-                    ),
-                    &asteroid_model1,
-                    ASTEROID1
-                ));
-            
-            } else {
-                asteroid_attributes.push_back(ModelAttributes(
-                    current_frame,
-                    glm::vec3(
-                        (float) -20 + rand() % 41,
-                        (float) -20 + rand() % 41,
-                        0.0f
-                    ),
-                    &asteroid_model2,
-                    ASTEROID2
-                ));
-            }
+        draw_frame(frame);
+        glfwSwapBuffers(window);
+    }
 
-            type_of_asteroid = (type_of_asteroid + 1) % 2;
-            prev_asteroid_timestamp = current_frame;
-        
+    plasm_ball_instances.release();
+    explosion_instances.release();
+    dust_particles.release();
+    debris_particles.release();
+    frame_constants.release();
+
+    glDeleteVertexArrays(1, &skyboxVAO);
+    glDeleteBuffers(1, &skyboxVAO);
+
+    text_batch.release();
+    glyph_atlas.release();
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+
+int main(int argc, char** argv)
+{
+    // A fixed --seed replays the same spawns; by default every run differs.
+    // --record file saves the session's input, --replay file plays one
+    // back in real time, or as fast as possible with --fast. --scenario
+    // file changes how densely things spawn and prints frame metrics every
+    // second; a replay needs the scenario it was recorded with.
+    uint64_t seed = time(0);
+    const char *replay_path = nullptr;
+    const char *scenario_path = nullptr;
+    bool replay_fast = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--seed") == 0 and i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+
+        } else if (std::strcmp(argv[i], "--record") == 0 and i + 1 < argc) {
+            record_path = argv[++i];
+
+        } else if (std::strcmp(argv[i], "--replay") == 0 and i + 1 < argc) {
+            replay_path = argv[++i];
+
+        } else if (std::strcmp(argv[i], "--scenario") == 0 and
+                i + 1 < argc) {
+
+            scenario_path = argv[++i];
+
+        } else if (std::strcmp(argv[i], "--fast") == 0) {
+            replay_fast = true;
         }
+    }
 
-        // Add new dust piece.
-        if (current_frame - prev_dust_timestamp > 0.1f) {
-            dust_attributes.push_back(ModelAttributes(
-                current_frame,
-                glm::vec3(
-                    (float) -20 + rand() % 41,
-                    (float) -20 + rand() % 41,
-                    0.0f
-                ),
-                &dust_model,
-                DUST
-            ));
-
-            prev_dust_timestamp = current_frame;
+    float sim_tick = SIM_TICK;
+
+    if (replay_path != nullptr) {
+        if (not recording.load(replay_path)) {
+            std::cerr << "Failed to load input recording " << replay_path
+                      << std::endl;
+            return -1;
         }
 
-        clear_objects();
-
-        std::set<unsigned int> deleted_models_pos;
-        std::set<unsigned int> deleted_asteroids_pos;
-        std::set<unsigned int> deleted_plasm_balls_pos;
-        std::set<unsigned int> deleted_enemy_plasm_balls_pos;
-
-        // Process starships.
-        for (unsigned int i = 0; i < starship_attributes.size(); i++) {
-            draw_starship(starship_attributes[i]);
-            if (starship_attributes[i].real_coords.z < 0.0f and
-                    current_frame -
-                    starship_attributes[i].last_shot_timestamp > 1.5f and
-                    not game_over) {
-                
-                enemy_plasm_ball_attributes.push_back(ModelAttributes(
-                    current_frame,
-                    starship_attributes[i].real_coords,
-                    &sphere_model,
-                    PLASM_BALL
-                ));
-
-                starship_attributes[i].last_shot_timestamp = current_frame;
-            }
+        replaying = true;
+        record_path = nullptr;
+        seed = recording.seed;
+        sim_tick = recording.tick;
 
-            if (starship_attributes[i].real_coords.z > 0.0f
-                    and not game_over) {
-                
-                if ((camera.Position.x >= 0 and
-                        starship_attributes[i].real_coords.x >= 0 ) or
-                        (camera.Position.x <= 0 and 
-                        starship_attributes[i].real_coords.x <= 0 )) {
-                    
-                    health -= 10;
-
-                    deleted_models_pos.insert(i);
-                    explosion_attributes.push_back(ModelAttributes(
-                        current_frame,
-                        glm::vec3(
-                            starship_attributes[i].real_coords.x,
-                            starship_attributes[i].real_coords.y,
-                            starship_attributes[i].real_coords.z - 6.0f
-                        ),
-                        &sphere_model,
-                        EXPLOSION
-                    ));
-
-                    play_sound("../resources/sounds/explosion.wav", false);
-                }
-            }
+        std::cout << "Replaying " << recording.ticks.size() << " ticks from "
+                  << replay_path << std::endl;
 
-            for (unsigned int j = 0; j < plasm_ball_attributes.size(); j++) {
-                if (glm::distance(starship_attributes[i].real_coords,
-                                  plasm_ball_attributes[j].real_coords) <=
-                        DIST) {
-
-                    if (starship_attributes[i].obj_type == VULCAN) {
-                        score += 15;
-                    
-                    } else {
-                        score += 10;
-                    }
-
-                    deleted_models_pos.insert(i);
-                    deleted_plasm_balls_pos.insert(j);
-
-                    explosion_attributes.push_back(ModelAttributes(
-                        current_frame,
-                        starship_attributes[i].real_coords,
-                        &sphere_model,
-                        EXPLOSION
-                    ));
-
-                    play_sound("../resources/sounds/explosion.wav",
-                               false);
-                }
-            }
-        }
+    } else {
+        recording.seed = seed;
+        recording.tick = sim_tick;
 
-        // Process asteroids.
-        for (unsigned int i = 0; i < asteroid_attributes.size(); i++) {
-            draw_asteroid(asteroid_attributes[i]);
-
-            if (asteroid_attributes[i].real_coords.z > 0.0f
-                    and not game_over) {
-                
-                if ((camera.Position.x >= 0 and
-                        asteroid_attributes[i].real_coords.x >= 0 ) or
-                        (camera.Position.x <= 0 and
-                        asteroid_attributes[i].real_coords.x <= 0 )) {
-                        
-                        health -= 10;
-                        
-                        deleted_asteroids_pos.insert(i);
-                        explosion_attributes.push_back(ModelAttributes(
-                            current_frame,
-                            glm::vec3(
-                                asteroid_attributes[i].real_coords.x,
-                                asteroid_attributes[i].real_coords.y,
-                                asteroid_attributes[i].real_coords.z - 6.0f
-                            ),
-                            &sphere_model,
-                            EXPLOSION
-                        ));
-
-                        asteroid_fragment_attributes.push_back(
-                            {
-                                current_frame,
-                                asteroid_attributes[i].real_coords,
-                                glm::vec3(1.0f, 0.0f, 0.0f)
-                            });
-
-                        asteroid_fragment_attributes.push_back(
-                            {
-                                current_frame,
-                                asteroid_attributes[i].real_coords,
-                                glm::vec3(-1.0f, 0.0f, 0.0f)
-                            });
-
-                        asteroid_fragment_attributes.push_back(
-                            {
-                                current_frame,
-                                asteroid_attributes[i].real_coords,
-                                glm::vec3(0.0f, 1.0f, 0.0f)
-                            });
-
-                        asteroid_fragment_attributes.push_back(
-                            {
-                                current_frame,
-                                asteroid_attributes[i].real_coords,
-                                glm::vec3(0.0f, -1.0f, 0.0f)
-                            });
-
-                        asteroid_fragment_attributes.push_back(
-                            {
-                                current_frame,
-                                asteroid_attributes[i].real_coords,
-                                glm::vec3(0.0f, 0.0f, -1.0f)
-                            });
-
-                        play_sound("../resources/sounds/explosion.wav",
-                                   false);
-                }
-            }
+        // Ten minutes of play before the recording has to grow.
+        recording.ticks.reserve((unsigned long) (600.0f / sim_tick));
+    }
 
-            for (unsigned int j = 0; j < plasm_ball_attributes.size(); j++) {
-                float dist = DIST;
-                if (asteroid_attributes[i].obj_type == ASTEROID2) {
-                    dist += 0.5f;
-                }
+    simulation.reseed(seed);
+    std::cout << "Seed: " << seed << std::endl;
 
-                if (glm::distance(asteroid_attributes[i].real_coords,
-                                  plasm_ball_attributes[j].real_coords) <=
-                        dist) {
-
-                    score += 5;
-
-                    deleted_asteroids_pos.insert(i);
-                    deleted_plasm_balls_pos.insert(j);
-
-                    explosion_attributes.push_back(ModelAttributes(
-                        current_frame,
-                        asteroid_attributes[i].real_coords,
-                        &sphere_model,
-                        EXPLOSION
-                    ));
-
-                    asteroid_fragment_attributes.push_back(
-                        {
-                            current_frame,
-                            asteroid_attributes[i].real_coords,
-                            glm::vec3(1.0f, 0.0f, 0.0f)
-                        });
-
-                    asteroid_fragment_attributes.push_back(
-                        {
-                            current_frame,
-                            asteroid_attributes[i].real_coords,
-                            glm::vec3(-1.0f, 0.0f, 0.0f)
-                        });
-
-                    asteroid_fragment_attributes.push_back(
-                        {
-                            current_frame,
-                            asteroid_attributes[i].real_coords,
-                            glm::vec3(0.0f, 1.0f, 0.0f)
-                        });
-
-                    asteroid_fragment_attributes.push_back(
-                        {
-                            current_frame,
-                            asteroid_attributes[i].real_coords,
-                            glm::vec3(0.0f, -1.0f, 0.0f)
-                        });
-
-                    asteroid_fragment_attributes.push_back(
-                        {
-                            current_frame,
-                            asteroid_attributes[i].real_coords,
-                            glm::vec3(0.0f, 0.0f, -1.0f)
-                        });
-
-                    play_sound("../resources/sounds/explosion.wav",
-                               false);
-                }
-            }
-        }
+    if (scenario_path != nullptr) {
+        Scenario scenario;
 
-        for (auto &it: plasm_ball_attributes) {
-            draw_plasm_ball(sphere_model, it);
+        if (not scenario.load(scenario_path)) {
+            return -1;
         }
 
-        // Process enemy plasm balls.
-        for (unsigned int i = 0; i < enemy_plasm_ball_attributes.size(); i++) {
-            draw_enemy_plasm_ball(sphere_model,
-                                  enemy_plasm_ball_attributes[i]);
-
-            if (enemy_plasm_ball_attributes[i].real_coords.z > 0.0f
-                    and not game_over) {
-                
-                health -= 5;
-                deleted_enemy_plasm_balls_pos.insert(i);
-                play_sound("../resources/sounds/enemy_hit.mp3",
-                           false);
+        simulation.set_scenario(scenario);
+        std::cout << "Scenario: " << scenario_path << std::endl;
+    }
+
+    // Position passes and hit tests use every core.
+    JobSystem jobs;
+
+    if (jobs.thread_count() > 1) {
+        simulation.set_job_system(&jobs);
+    }
+
+	if (!glfwInit()) {
+        return -1;
+    }
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); 
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); 
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); 
+	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE); 
+
+    GLFWwindow*  window = glfwCreateWindow(WIDTH,
+                                           HEIGHT,
+                                           game_name,
+                                           nullptr,
+                                           nullptr);
+
+	if (window == nullptr) {
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    sound_engine = createIrrKlangDevice();
+    play_sound("../resources/sounds/background_music.mp3", true);
+
+    std::thread render_thread(render_frames,
+                              window,
+                              not (replaying and replay_fast),
+                              simulation.get_scenario());
+
+    float sim_accumulator = 0.0f;
+    lastFrame = glfwGetTime();
+
+    long frame = 0;
+    bool rendering = true;
+
+    // Wall time of every replayed frame, reported when the replay ends.
+    std::vector<float> frame_ms;
+    if (replaying) {
+        frame_ms.reserve(2 * recording.ticks.size() + 1);
+    }
+
+    // Frame metrics of the current second, printed when running a
+    // scenario.
+    long metrics_frames = 0;
+    float metrics_frame_ms = 0.0f;
+    float metrics_max_ms = 0.0f;
+    float metrics_sim_ms = 0.0f;
+    auto metrics_start = std::chrono::steady_clock::now();
+
+    // State changes, culling, triangles and dropped debris bursts of the
+    // latest frame the render thread has finished.
+    StateChanges frame_submitted_changes = StateChanges();
+    StateChanges frame_executed_changes = StateChanges();
+    unsigned int frame_objects_drawn = 0;
+    unsigned int frame_objects_culled = 0;
+    unsigned long frame_triangles = 0;
+    unsigned long frame_full_triangles = 0;
+    unsigned long frame_debris_bursts_dropped = 0;
+
+    // Simulation loop.
+    while (rendering and !glfwWindowShouldClose(window)) {
+        unsigned long frame_allocations = allocation_count();
+        auto frame_start = std::chrono::steady_clock::now();
+
+        glfwPollEvents();
+
+        current_frame = glfwGetTime();
+        deltaTime = current_frame - lastFrame;
+        lastFrame = current_frame;
+
+        processInput(window);
+
+        if (replaying and replay_fast) {
+            // One tick per frame, without waiting for the wall clock.
+            if (replay_tick < recording.ticks.size()) {
+                step_simulation(sim_tick);
             }
-        }
 
-        for (auto &it: dust_attributes) {
-            draw_dust(dust_model, it);
-        }
+            // Draw exactly the tick just taken.
+            sim_accumulator = sim_tick;
 
-        for (auto &it: explosion_attributes) {
-            draw_exploison(sphere_model, it);
+        } else {
+            // Advance the simulation in fixed ticks, dropping time after a
+            // long stall instead of trying to catch up with it.
+            sim_accumulator += std::min(deltaTime, 0.25f);
+            while (sim_accumulator >= sim_tick) {
+                if (replaying and replay_tick == recording.ticks.size()) {
+                    break;
+                }
+
+                step_simulation(sim_tick);
+                sim_accumulator -= sim_tick;
+            }
         }
 
-        for (auto &it: asteroid_fragment_attributes) {
-            draw_asteroid_fragment(asteroid_model2, it);
+        if (replaying and replay_tick == recording.ticks.size()) {
+            glfwSetWindowShouldClose(window, true);
         }
 
-        draw_skybox();
+        auto sim_end = std::chrono::steady_clock::now();
 
-        // Clear destroyed objects.
-        auto model_attributes_begin = starship_attributes.begin();
-        auto asteroid_attributes_begin = asteroid_attributes.begin();
-        auto plasm_ball_attributes_begin = plasm_ball_attributes.begin();
-        auto enemy_plasm_ball_attributes_begin =
-                enemy_plasm_ball_attributes.begin();
+        camera.Position.x = simulation.player_position.x;
+        play_sound_cues();
 
-        for (auto it = deleted_models_pos.rbegin();
-                it != deleted_models_pos.rend(); ++it) {
+        if (simulation.game_over and
+                simulation.time() - simulation.game_over_timestamp >
+                        OUTRO_TIMEOUT) {
 
-            starship_attributes.erase(
-                    model_attributes_begin + *it);
+            glfwSetWindowShouldClose(window, true);
         }
 
-        for (auto it = deleted_asteroids_pos.rbegin();
-                it != deleted_asteroids_pos.rend(); ++it) {
+        FrameSnapshot &snapshot = snapshots.back();
 
-            asteroid_attributes.erase(
-                    asteroid_attributes_begin + *it);
-        }
+        capture_snapshot(simulation,
+                         sim_accumulator / sim_tick,
+                         sim_tick,
+                         snapshot);
+
+        snapshot.view = camera.GetViewMatrix();
+        snapshot.camera_position = camera.Position;
+        snapshot.zoom = camera.Zoom;
+        snapshot.framebuffer_width = framebuffer_width;
+        snapshot.framebuffer_height = framebuffer_height;
 
-        for (auto it = deleted_plasm_balls_pos.rbegin();
-                it != deleted_plasm_balls_pos.rend(); ++it) {
+        // Hand the frame over and wait until the render thread has taken
+        // it, not until it has been drawn.
+        {
+            std::unique_lock<std::mutex> lock(frame_mutex);
 
-            plasm_ball_attributes.erase(
-                    plasm_ball_attributes_begin + *it);
+            snapshots.publish();
+            frames_published++;
         }
 
-        for (auto it = deleted_enemy_plasm_balls_pos.rbegin();
-                it != deleted_enemy_plasm_balls_pos.rend(); ++it) {
+        frame_handoff.notify_all();
 
-            enemy_plasm_ball_attributes.erase(
-                    enemy_plasm_ball_attributes_begin + *it);
+        {
+            std::unique_lock<std::mutex> lock(frame_mutex);
+
+            frame_handoff.wait(lock, []() {
+                return frames_taken == frames_published or
+                       not render_running;
+            });
+
+            rendering = render_running;
+            frame_submitted_changes = submitted_changes;
+            frame_executed_changes = executed_changes;
+            frame_objects_drawn = last_objects_drawn;
+            frame_objects_culled = last_objects_culled;
+            frame_triangles = last_triangles;
+            frame_full_triangles = last_full_triangles;
+            frame_debris_bursts_dropped = last_debris_bursts_dropped;
         }
 
+        auto frame_end = std::chrono::steady_clock::now();
+        float this_frame_ms = std::chrono::duration<float, std::milli>(
+                frame_end - frame_start).count();
 
-        if (health <= 0 and not game_over) {
-            health = 0;
-            game_over = true;
-            game_over_timestamp = current_frame;
+        if (replaying) {
+            frame_ms.push_back(this_frame_ms);
+        }
 
-            play_sound(large_explosion,
-                       false);
+        if (scenario_path != nullptr) {
+            metrics_frames++;
+            metrics_frame_ms += this_frame_ms;
+            metrics_max_ms = std::max(metrics_max_ms, this_frame_ms);
+            metrics_sim_ms += std::chrono::duration<float, std::milli>(
+                    sim_end - frame_start).count();
+
+            if (frame_end - metrics_start >= std::chrono::seconds(1)) {
+                std::printf("%ld frames, mean %.2f ms, max %.2f ms, "
+                            "sim %.2f ms, ships %u, plasm balls %u, "
+                            "enemy %u, asteroids %u\n",
+                            metrics_frames,
+                            metrics_frame_ms / metrics_frames,
+                            metrics_max_ms,
+                            metrics_sim_ms / metrics_frames,
+                            simulation.starships.size(),
+                            simulation.plasm_balls.size(),
+                            simulation.enemy_plasm_balls.size(),
+                            simulation.asteroids.size());
+
+                std::printf("    switches per frame, programs/textures/VAOs: "
+                            "submitted %u/%u/%u, sorted %u/%u/%u\n",
+                            frame_submitted_changes.programs,
+                            frame_submitted_changes.textures,
+                            frame_submitted_changes.vaos,
+                            frame_executed_changes.programs,
+                            frame_executed_changes.textures,
+                            frame_executed_changes.vaos);
+
+                std::printf("    objects drawn %u, culled %u, triangles %lu, "
+                            "%lu without LODs\n",
+                            frame_objects_drawn,
+                            frame_objects_culled,
+                            frame_triangles,
+                            frame_full_triangles);
+
+                std::printf("    debris bursts dropped so far %lu\n",
+                            frame_debris_bursts_dropped);
+
+                metrics_frames = 0;
+                metrics_frame_ms = 0.0f;
+                metrics_max_ms = 0.0f;
+                metrics_sim_ms = 0.0f;
+                metrics_start = frame_end;
+            }
         }
 
-        if (game_over) {
-            RenderText(text_program,
-                       "Your soul has been taken by the Space",
-                       369.0f,
-                       505.0f,
-                       0.5f,
-                       glm::vec3(1.0f, 1.0f, 1.0f));
-
-            RenderText(text_program,
-                       "And you will know My name is the Lord",
-                       439.0f,
-                       415.0f,
-                       0.425f,
-                       glm::vec3(1.0f, 1.0f, 1.0f));
-
-            RenderText(text_program,
-                       "    When I lay My vengeance upon thee",
-                       435.0f,
-                       392.0f,
-                       0.425f,
-                       glm::vec3(1.0f, 1.0f, 1.0f));
-
-            RenderText(text_program,
-                       "                 OT: Ezekiel, XXV, 17",
-                       507.0f,
-                       369.0f,
-                       0.425f,
-                       glm::vec3(1.0f, 1.0f, 1.0f));
-
-            RenderText(text_program,
-                       std::string("Exit in ") +
-                       std::to_string(OUTRO_TIMEOUT -
-                           ((int) (current_frame - game_over_timestamp))),
-                       506.0f,
-                       279.0f,
-                       0.665f,
-                       glm::vec3(1.0f, 1.0f, 1.0f));
-
-            if (current_frame - game_over_timestamp > OUTRO_TIMEOUT) {
-                glfwSetWindowShouldClose(window, true);
-            } 
-        
-        } else {
-            RenderText(text_program,
-                       "+",
-                       555.0f,
-                       415.0f,
-                       0.5f,
-                       glm::vec3(1.0f, 1.0f, 1.0f));
+        frame_allocations = allocation_count() - frame_allocations;
+        if (frame_allocations > 0) {
+            std::cout << "Frame " << frame << ": " << frame_allocations
+                      << " allocations" << std::endl;
         }
 
-        RenderText(text_program,
-                   std::string("Total score: ") +
-                   std::to_string(score),
-                   3.0f,
-                   32,
-                   0.5f,
-                   glm::vec3(1.0f, 1.0f, 1.0f));
+        frame++;
+    }
 
-        RenderText(text_program,
-                   std::string("Health: ") +
-                   std::to_string(health),
-                   3.0f,
-                   3.0f,
-                   0.5f,
-                   glm::vec3(1.0f, 1.0f, 1.0f));
+    stop_rendering();
+    render_thread.join();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (replaying) {
+        print_frame_stats("Frames", summarize_frame_times(frame_ms));
+        std::cout << "Score: " << simulation.score << std::endl;
     }
 
-    
-    glDeleteVertexArrays(1, &skyboxVAO);
-    glDeleteBuffers(1, &skyboxVAO);
+    if (record_path != nullptr) {
+        if (recording.save(record_path)) {
+            std::cout << "Recorded " << recording.ticks.size()
+                      << " ticks to " << record_path << std::endl;
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+        } else {
+            std::cerr << "Failed to save input recording " << record_path
+                      << std::endl;
+        }
+    }
 
     if (sound_engine) {
         sound_engine->drop();
@@ -7,7 +7,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "ShaderProgram.h"
+#include "mesh_simplify.h"
 
+#include <cstdio>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -34,13 +36,25 @@ struct Texture {
     string path;
 };
 
+// a level of detail: a range of the mesh's element buffer
+struct MeshLod {
+    unsigned int first;
+    unsigned int count;
+};
+
 class Mesh {
 public:
+    // at most this many levels of detail per mesh
+    static const unsigned int MAX_LODS = 4;
+
     /*  Mesh Data  */
     vector<Vertex> vertices;
     vector<unsigned int> indices;
     vector<Texture> textures;
     unsigned int VAO;
+    // level 0 is the mesh as loaded, each further level has about a quarter of the triangles of the one before;
+    // small meshes may have fewer levels
+    vector<MeshLod> lods;
 
     /*  Functions  */
     // constructor
@@ -50,55 +64,166 @@ public:
         this->indices = indices;
         this->textures = textures;
 
+        // simplify the mesh into its levels of detail, all indexing the same vertices
+        vector<unsigned int> elements = buildLods();
+
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(elements);
+    }
+
+    // The steps of a draw. The render queue issues them itself, tracking GL state so
+    // that it only binds what changes.
+
+    // binds every texture to its own unit and points the matching sampler at it
+    void BindTextures(const ShaderProgram &shader) const
+    {
+        const MaterialBindings &material = BindingsFor(shader);
+
+        for(const TextureBinding &binding : material.textures)
+        {
+            glActiveTexture(binding.unit);
+            glUniform1i(binding.sampler, binding.unit - GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, binding.texture);
+        }
+    }
+
+    // points the per-instance model matrix attributes of the bound VAO at instance_buffer, starting
+    // at matrix first; the VAO keeps these pointers, so this is needed whenever the buffer changes
+    void BindInstanceMatrices(GLuint instance_buffer, unsigned int first = 0) const
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+        for(unsigned int column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(INSTANCE_MATRIX_LOCATION + column);
+            glVertexAttribPointer(INSTANCE_MATRIX_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  (void*)(first * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION + column, 1);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
-    // render the mesh
-    void Draw(ShaderProgram shader) 
+    // whether other binds the same textures to the same units
+    bool SameTextures(const Mesh &other) const
+    {
+        if(textures.size() != other.textures.size())
+            return false;
+
+        for(unsigned int i = 0; i < textures.size(); i++)
+            if(textures[i].id != other.textures[i].id || textures[i].type != other.textures[i].type)
+                return false;
+
+        return true;
+    }
+
+private:
+    /*  Render data  */
+    unsigned int VBO, EBO;
+
+    // first of the four attribute locations of a per-instance model matrix
+    static const unsigned int INSTANCE_MATRIX_LOCATION = 5;
+
+    // levels below this many triangles aren't worth a draw of their own
+    static const unsigned int MIN_LOD_TRIANGLES = 16;
+
+    // one texture of the mesh: the unit it goes to and the location of the sampler that reads it
+    struct TextureBinding {
+        GLenum unit;
+        unsigned int texture;
+        GLint sampler;
+    };
+
+    // everything BindTextures needs to draw the mesh with one program, worked out on the first draw
+    struct MaterialBindings {
+        GLuint program;
+        vector<TextureBinding> textures;
+    };
+
+    // one table per program the mesh has been drawn with, usually one or two
+    mutable vector<MaterialBindings> materials;
+
+    /*  Functions    */
+    // the binding table for shader, built the first time the mesh is drawn with it; sampler
+    // locations are looked up once here and not on every draw (they go stale if the program is relinked)
+    const MaterialBindings &BindingsFor(const ShaderProgram &shader) const
     {
-        // bind appropriate textures
+        for(const MaterialBindings &material : materials)
+            if(material.program == shader.GetProgram())
+                return material;
+
+        MaterialBindings material;
+        material.program = shader.GetProgram();
+
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
+            unsigned int number = 0;
+            const string &name = textures[i].type;
             if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
+                number = diffuseNr++;
             else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to stream
+                number = specularNr++;
             else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to stream
+                number = normalNr++;
              else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to stream
+                number = heightNr++;
+
+            char uniform_name[64];
+            snprintf(uniform_name, sizeof(uniform_name), "%s%u", name.c_str(), number);
 
-                                                     // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.GetProgram(), (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            // a sampler the program doesn't have stays at -1, which glUniform1i ignores
+            TextureBinding binding;
+            binding.unit = GL_TEXTURE0 + i;
+            binding.texture = textures[i].id;
+            binding.sampler = glGetUniformLocation(shader.GetProgram(), uniform_name);
+            material.textures.push_back(binding);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+        materials.push_back(material);
+        return materials.back();
     }
 
-private:
-    /*  Render data  */
-    unsigned int VBO, EBO;
+    // fills lods and returns the element buffer holding all of them, level 0 first; a level is only
+    // kept if it at least halves the triangles of the one before
+    vector<unsigned int> buildLods()
+    {
+        vector<unsigned int> elements = indices;
+        lods.push_back(MeshLod{0, (unsigned int)indices.size()});
+
+        vector<glm::vec3> positions(vertices.size());
+        vector<glm::vec3> normals(vertices.size());
+        vector<glm::vec2> texCoords(vertices.size());
+        for(unsigned int i = 0; i < vertices.size(); i++)
+        {
+            positions[i] = vertices[i].Position;
+            normals[i] = vertices[i].Normal;
+            texCoords[i] = vertices[i].TexCoords;
+        }
+
+        MeshSimplifier simplifier(positions, normals, texCoords, indices);
+        vector<unsigned int> simplified;
+        while(lods.size() < MAX_LODS)
+        {
+            unsigned int target = lods.back().count / 3 / 4;
+            if(target < MIN_LOD_TRIANGLES)
+                break;
+
+            simplifier.simplify(target, simplified);
+            if(simplified.size() * 2 > lods.back().count)
+                break;
+
+            lods.push_back(MeshLod{(unsigned int)elements.size(), (unsigned int)simplified.size()});
+            elements.insert(elements.end(), simplified.begin(), simplified.end());
+        }
+
+        return elements;
+    }
 
-    /*  Functions    */
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const vector<unsigned int> &elements)
     {
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
@@ -114,7 +239,7 @@ private:
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size() * sizeof(unsigned int), &elements[0], GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
         // vertex Positions
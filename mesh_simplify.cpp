@@ -0,0 +1,461 @@
+#include "mesh_simplify.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+
+// How much more a boundary edge resists moving than a face of the same
+// size, so that open edges of a mesh keep their outline.
+static const double BOUNDARY_WEIGHT = 10.0;
+
+static const uint32_t NO_VERTEX = 0xffffffff;
+
+namespace {
+
+// Bit patterns of N floats, for welding exactly equal values.
+template <unsigned int N>
+struct FloatKey
+{
+    uint32_t bits[N];
+
+    bool operator==(const FloatKey &other) const
+    {
+        return std::memcmp(bits, other.bits, sizeof(bits)) == 0;
+    }
+};
+
+template <unsigned int N>
+struct FloatKeyHash
+{
+    size_t operator()(const FloatKey<N> &key) const
+    {
+        size_t hash = 0;
+
+        for (unsigned int i = 0; i < N; i++) {
+            hash = hash * 73856093u ^ key.bits[i];
+        }
+
+        return hash;
+    }
+};
+
+typedef FloatKey<3> PositionKey;
+typedef FloatKey<8> VertexKey;
+
+}
+
+static bool contains(const uint32_t point[3], uint32_t p)
+{
+    return point[0] == p or point[1] == p or point[2] == p;
+}
+
+MeshSimplifier::MeshSimplifier(const std::vector<glm::vec3> &positions,
+                               const std::vector<glm::vec3> &normals,
+                               const std::vector<glm::vec2> &texture_coords,
+                               const std::vector<unsigned int> &indices)
+    : live_triangles {0}
+{
+    // Weld vertices that share a position into one point, and vertices
+    // that share all three attributes into the first of them.
+    std::unordered_map<PositionKey, uint32_t, FloatKeyHash<3>> welded;
+    std::unordered_map<VertexKey, uint32_t, FloatKeyHash<8>> same;
+    std::vector<uint32_t> point_of(positions.size());
+    std::vector<uint32_t> vertex_of(positions.size());
+
+    for (uint32_t v = 0; v < positions.size(); v++) {
+        PositionKey key;
+        std::memcpy(key.bits, &positions[v], sizeof(key.bits));
+
+        auto found = welded.find(key);
+
+        if (found != welded.end()) {
+            point_of[v] = found->second;
+
+        } else {
+            point_of[v] = points.size();
+            welded[key] = points.size();
+            points.push_back(glm::dvec3(positions[v]));
+        }
+
+        VertexKey vertex_key;
+        std::memcpy(vertex_key.bits, &positions[v], 12);
+        std::memcpy(vertex_key.bits + 3, &normals[v], 12);
+        std::memcpy(vertex_key.bits + 6, &texture_coords[v], 8);
+
+        auto first = same.insert(std::make_pair(vertex_key, v)).first;
+        vertex_of[v] = first->second;
+    }
+
+    Quadric zero;
+    std::memset(&zero, 0, sizeof(zero));
+
+    quadrics.assign(points.size(), zero);
+    point_triangles.resize(points.size());
+    version.assign(points.size(), 0);
+
+    parent.resize(points.size());
+    for (uint32_t p = 0; p < points.size(); p++) {
+        parent[p] = p;
+    }
+
+    for (unsigned int i = 0; i + 2 < indices.size(); i += 3) {
+        Triangle triangle;
+        triangle.removed = false;
+
+        for (unsigned int k = 0; k < 3; k++) {
+            triangle.vertex[k] = vertex_of[indices[i + k]];
+            triangle.point[k] = point_of[indices[i + k]];
+        }
+
+        // Triangles already degenerate after welding are dropped.
+        if (triangle.point[0] == triangle.point[1] or
+                triangle.point[1] == triangle.point[2] or
+                triangle.point[2] == triangle.point[0]) {
+
+            continue;
+        }
+
+        const glm::dvec3 &p0 = points[triangle.point[0]];
+        glm::dvec3 normal = glm::cross(points[triangle.point[1]] - p0,
+                                       points[triangle.point[2]] - p0);
+        double length = glm::length(normal);
+
+        if (length > 0.0) {
+            normal /= length;
+            Quadric q = plane_quadric(normal,
+                                      -glm::dot(normal, p0),
+                                      0.5 * length);
+
+            for (unsigned int k = 0; k < 3; k++) {
+                add(quadrics[triangle.point[k]], q);
+            }
+        }
+
+        uint32_t t = triangles.size();
+
+        for (unsigned int k = 0; k < 3; k++) {
+            point_triangles[triangle.point[k]].push_back(t);
+        }
+
+        triangles.push_back(triangle);
+    }
+
+    live_triangles = triangles.size();
+
+    add_boundary_planes();
+
+    for (auto &triangle: triangles) {
+        for (unsigned int k = 0; k < 3; k++) {
+            push_collapse(triangle.point[k], triangle.point[(k + 1) % 3]);
+        }
+    }
+}
+
+void MeshSimplifier::simplify(unsigned int target_triangles,
+                              std::vector<unsigned int> &result)
+{
+    while (live_triangles > target_triangles and not heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end());
+        Collapse c = heap.back();
+        heap.pop_back();
+
+        // Stale: an end is gone or its quadric has changed since.
+        if (parent[c.from] != c.from or parent[c.to] != c.to or
+                version[c.from] != c.from_version or
+                version[c.to] != c.to_version) {
+
+            continue;
+        }
+
+        if (flips(c.from, c.to) or not match_corners(c.from, c.to)) {
+            continue;
+        }
+
+        collapse(c.from, c.to);
+    }
+
+    result.clear();
+
+    for (auto &triangle: triangles) {
+        if (not triangle.removed) {
+            result.insert(result.end(),
+                          triangle.vertex,
+                          triangle.vertex + 3);
+        }
+    }
+}
+
+MeshSimplifier::Quadric MeshSimplifier::plane_quadric(
+        const glm::dvec3 &normal,
+        double offset,
+        double weight)
+{
+    double p[4] = {normal.x, normal.y, normal.z, offset};
+
+    Quadric q;
+    unsigned int n = 0;
+
+    for (unsigned int row = 0; row < 4; row++) {
+        for (unsigned int column = row; column < 4; column++) {
+            q.a[n++] = weight * p[row] * p[column];
+        }
+    }
+
+    return q;
+}
+
+void MeshSimplifier::add(Quadric &sum, const Quadric &q)
+{
+    for (unsigned int i = 0; i < 10; i++) {
+        sum.a[i] += q.a[i];
+    }
+}
+
+// p^T Q p for the homogeneous point (p, 1).
+double MeshSimplifier::error(const Quadric &q, const glm::dvec3 &p)
+{
+    const double *a = q.a;
+
+    return a[0] * p.x * p.x + 2 * a[1] * p.x * p.y + 2 * a[2] * p.x * p.z +
+           2 * a[3] * p.x +
+           a[4] * p.y * p.y + 2 * a[5] * p.y * p.z + 2 * a[6] * p.y +
+           a[7] * p.z * p.z + 2 * a[8] * p.z +
+           a[9];
+}
+
+void MeshSimplifier::add_boundary_planes()
+{
+    // Edges used by one triangle only, keyed by their ordered ends.
+    std::unordered_map<uint64_t, int> edge_count;
+
+    for (auto &triangle: triangles) {
+        for (unsigned int k = 0; k < 3; k++) {
+            uint64_t a = triangle.point[k];
+            uint64_t b = triangle.point[(k + 1) % 3];
+            edge_count[std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+
+    for (auto &triangle: triangles) {
+        const glm::dvec3 &p0 = points[triangle.point[0]];
+        glm::dvec3 face = glm::cross(points[triangle.point[1]] - p0,
+                                     points[triangle.point[2]] - p0);
+
+        for (unsigned int k = 0; k < 3; k++) {
+            uint64_t a = triangle.point[k];
+            uint64_t b = triangle.point[(k + 1) % 3];
+
+            if (edge_count[std::min(a, b) << 32 | std::max(a, b)] != 1) {
+                continue;
+            }
+
+            // The plane through the edge, perpendicular to the face.
+            glm::dvec3 edge = points[b] - points[a];
+            glm::dvec3 normal = glm::cross(edge, face);
+            double length = glm::length(normal);
+
+            if (length == 0.0) {
+                continue;
+            }
+
+            normal /= length;
+            Quadric q = plane_quadric(normal,
+                                      -glm::dot(normal, points[a]),
+                                      BOUNDARY_WEIGHT *
+                                              glm::dot(edge, edge));
+
+            add(quadrics[a], q);
+            add(quadrics[b], q);
+        }
+    }
+}
+
+// Queues the cheaper direction of collapsing the edge between a and b.
+void MeshSimplifier::push_collapse(uint32_t a, uint32_t b)
+{
+    Quadric q = quadrics[a];
+    add(q, quadrics[b]);
+
+    double onto_b = error(q, points[b]);
+    double onto_a = error(q, points[a]);
+
+    Collapse c;
+
+    if (onto_b <= onto_a) {
+        c.cost = onto_b;
+        c.from = a;
+        c.to = b;
+
+    } else {
+        c.cost = onto_a;
+        c.from = b;
+        c.to = a;
+    }
+
+    c.from_version = version[c.from];
+    c.to_version = version[c.to];
+
+    heap.push_back(c);
+    std::push_heap(heap.begin(), heap.end());
+}
+
+// Whether moving from onto to turns any triangle that survives it over.
+bool MeshSimplifier::flips(uint32_t from, uint32_t to) const
+{
+    for (uint32_t t: point_triangles[from]) {
+        const Triangle &triangle = triangles[t];
+
+        if (triangle.removed or not contains(triangle.point, from) or
+                contains(triangle.point, to)) {
+
+            continue;
+        }
+
+        glm::dvec3 before[3];
+        glm::dvec3 after[3];
+
+        for (unsigned int k = 0; k < 3; k++) {
+            before[k] = points[triangle.point[k]];
+            after[k] = triangle.point[k] == from ? points[to] : before[k];
+        }
+
+        glm::dvec3 old_normal = glm::cross(before[1] - before[0],
+                                           before[2] - before[0]);
+        glm::dvec3 new_normal = glm::cross(after[1] - after[0],
+                                           after[2] - after[0]);
+
+        if (glm::dot(old_normal, new_normal) <= 0.0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Pairs the vertex each triangle of the edge uses at from with the one it
+// uses at to. Fails if the pairing is ambiguous, or if a triangle that
+// moves onto to has a corner at from that no triangle of the edge shares:
+// that corner is on a seam the edge does not run along.
+bool MeshSimplifier::match_corners(uint32_t from, uint32_t to)
+{
+    corner_pairs.clear();
+
+    for (uint32_t t: point_triangles[from]) {
+        const Triangle &triangle = triangles[t];
+
+        if (triangle.removed or not contains(triangle.point, from) or
+                not contains(triangle.point, to)) {
+
+            continue;
+        }
+
+        uint32_t at_from = NO_VERTEX;
+        uint32_t at_to = NO_VERTEX;
+
+        for (unsigned int k = 0; k < 3; k++) {
+            if (triangle.point[k] == from) {
+                at_from = triangle.vertex[k];
+
+            } else if (triangle.point[k] == to) {
+                at_to = triangle.vertex[k];
+            }
+        }
+
+        uint32_t paired = partner(at_from);
+
+        if (paired == NO_VERTEX) {
+            corner_pairs.push_back(std::make_pair(at_from, at_to));
+
+        } else if (paired != at_to) {
+            return false;
+        }
+    }
+
+    for (uint32_t t: point_triangles[from]) {
+        const Triangle &triangle = triangles[t];
+
+        if (triangle.removed or not contains(triangle.point, from) or
+                contains(triangle.point, to)) {
+
+            continue;
+        }
+
+        for (unsigned int k = 0; k < 3; k++) {
+            if (triangle.point[k] == from and
+                    partner(triangle.vertex[k]) == NO_VERTEX) {
+
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// The vertex at to paired with vertex at from by match_corners().
+uint32_t MeshSimplifier::partner(uint32_t vertex) const
+{
+    for (auto &pair: corner_pairs) {
+        if (pair.first == vertex) {
+            return pair.second;
+        }
+    }
+
+    return NO_VERTEX;
+}
+
+// Moves from onto to; match_corners(from, to) must have succeeded just
+// before.
+void MeshSimplifier::collapse(uint32_t from, uint32_t to)
+{
+    add(quadrics[to], quadrics[from]);
+    parent[from] = to;
+    version[to]++;
+
+    for (uint32_t t: point_triangles[from]) {
+        Triangle &triangle = triangles[t];
+
+        if (triangle.removed or not contains(triangle.point, from)) {
+            continue;
+        }
+
+        if (contains(triangle.point, to)) {
+            triangle.removed = true;
+            live_triangles--;
+            continue;
+        }
+
+        for (unsigned int k = 0; k < 3; k++) {
+            if (triangle.point[k] == from) {
+                triangle.point[k] = to;
+                triangle.vertex[k] = partner(triangle.vertex[k]);
+            }
+        }
+
+        point_triangles[to].push_back(t);
+    }
+
+    std::vector<uint32_t>().swap(point_triangles[from]);
+
+    // Drop stale entries around to, then requeue its edges with the new
+    // quadric.
+    std::vector<uint32_t> &around = point_triangles[to];
+    unsigned int kept = 0;
+
+    for (uint32_t t: around) {
+        if (not triangles[t].removed and contains(triangles[t].point, to)) {
+            around[kept++] = t;
+        }
+    }
+
+    around.resize(kept);
+
+    for (uint32_t t: around) {
+        for (unsigned int k = 0; k < 3; k++) {
+            if (triangles[t].point[k] != to) {
+                push_collapse(to, triangles[t].point[k]);
+            }
+        }
+    }
+}
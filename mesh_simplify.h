@@ -0,0 +1,120 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+// Quadric error metric simplification (Garland and Heckbert, 1997).
+//
+// Every vertex position carries a quadric: the summed squared distances to
+// the planes of the triangles around it, weighted by their area, plus
+// planes that hold open boundary edges in place. Edges are collapsed
+// cheapest first, the cost of moving one end onto the other being the
+// combined quadric evaluated there. Collapses that would flip a triangle
+// are skipped.
+//
+// A collapse moves one end of an edge onto the other, so no vertices are
+// made and every level can index the original vertex buffer. Vertices at
+// the same position are welded first, so a mesh split along texture seams
+// or hard edges is simplified as one surface. A corner that moves keeps
+// to its side of such a seam: it takes the vertex that the triangles of
+// the collapsed edge use on that side at the other end. Collapses that
+// would pull a seam corner off the seam are skipped.
+class MeshSimplifier
+{
+public:
+    MeshSimplifier(const std::vector<glm::vec3> &positions,
+                   const std::vector<glm::vec3> &normals,
+                   const std::vector<glm::vec2> &texture_coords,
+                   const std::vector<unsigned int> &indices);
+
+    // Simplifies further, until at most target_triangles remain or no
+    // collapse is left, and stores the remaining triangles in result.
+    // Successive calls with falling targets give a chain of levels.
+    void simplify(unsigned int target_triangles,
+                  std::vector<unsigned int> &result);
+
+    unsigned int triangle_count() const { return live_triangles; }
+
+private:
+    // Symmetric 4x4 matrix, upper triangle by rows.
+    struct Quadric
+    {
+        double a[10];
+    };
+
+    struct Triangle
+    {
+        // Welded positions, and the vertex each corner uses: the first of
+        // the original vertices with its position, normal and texture
+        // coordinates.
+        uint32_t point[3];
+        uint32_t vertex[3];
+        bool removed;
+    };
+
+    struct Collapse
+    {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t from_version;
+        uint32_t to_version;
+
+        bool operator<(const Collapse &other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    static Quadric plane_quadric(const glm::dvec3 &normal,
+                                 double offset,
+                                 double weight);
+
+    static void add(Quadric &sum, const Quadric &q);
+
+    static double error(const Quadric &q, const glm::dvec3 &p);
+
+    void add_boundary_planes();
+
+    void push_collapse(uint32_t a, uint32_t b);
+
+    bool flips(uint32_t from, uint32_t to) const;
+
+    bool match_corners(uint32_t from, uint32_t to);
+
+    uint32_t partner(uint32_t vertex) const;
+
+    void collapse(uint32_t from, uint32_t to);
+
+    std::vector<glm::dvec3> points;
+    std::vector<Quadric> quadrics;
+
+    // Vertex at from and vertex at to of each side of the edge being
+    // collapsed, filled by match_corners().
+    std::vector<std::pair<uint32_t, uint32_t>> corner_pairs;
+
+    // Triangles around each point. Entries go stale when a triangle is
+    // removed or moves off the point; they are skipped when read.
+    std::vector<std::vector<uint32_t>> point_triangles;
+
+    // Point each point has been collapsed into, itself while it lives.
+    std::vector<uint32_t> parent;
+
+    // Bumped whenever a point's quadric changes, so that queued collapses
+    // computed from the old one can be told apart.
+    std::vector<uint32_t> version;
+
+    std::vector<Triangle> triangles;
+    unsigned int live_triangles;
+
+    // Min-heap of candidate collapses.
+    std::vector<Collapse> heap;
+};
+
+
+#endif
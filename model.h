@@ -31,6 +31,9 @@ public:
     vector<Mesh> meshes;
     string directory;
     bool gammaCorrection;
+    // sphere around every vertex of every mesh, in model space, for culling
+    glm::vec3 boundsCenter;
+    float boundsRadius;
 
     /*  Functions   */
     // constructor, expects a filepath to a 3D model.
@@ -39,15 +42,9 @@ public:
     Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
     {
         loadModel(path);
+        computeBounds();
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(ShaderProgram shader)
-    {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
-    }
-    
 private:
     /*  Functions   */
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
@@ -69,6 +66,27 @@ private:
         processNode(scene->mRootNode, scene);
     }
 
+    // centres the bounding sphere on the box around all vertices and grows it to reach the farthest one
+    void computeBounds()
+    {
+        glm::vec3 lower(0.0f);
+        glm::vec3 upper(0.0f);
+        bool first = true;
+        for(const Mesh &mesh : meshes)
+            for(const Vertex &vertex : mesh.vertices)
+            {
+                lower = first ? vertex.Position : glm::min(lower, vertex.Position);
+                upper = first ? vertex.Position : glm::max(upper, vertex.Position);
+                first = false;
+            }
+
+        boundsCenter = 0.5f * (lower + upper);
+        boundsRadius = 0.0f;
+        for(const Mesh &mesh : meshes)
+            for(const Vertex &vertex : mesh.vertices)
+                boundsRadius = glm::max(boundsRadius, glm::distance(boundsCenter, vertex.Position));
+    }
+
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
     void processNode(aiNode *node, const aiScene *scene)
     {
@@ -0,0 +1,109 @@
+#include "particle_system.h"
+
+#include <cstddef>
+
+
+const std::vector<const char *> &ParticleSystem::varyings()
+{
+    static const std::vector<const char *> names {
+        "outPosition",
+        "outAge",
+        "outVelocity",
+        "outLifetime",
+        "outGeneration"
+    };
+
+    return names;
+}
+
+void ParticleSystem::create(const std::vector<Particle> &particles)
+{
+    release();
+
+    count = particles.size();
+
+    glGenBuffers(2, buffers);
+    glGenVertexArrays(2, vaos);
+
+    for (unsigned int k = 0; k < 2; k++) {
+        glBindVertexArray(vaos[k]);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[k]);
+        glBufferData(GL_ARRAY_BUFFER,
+                     count * sizeof(Particle),
+                     particles.data(),
+                     GL_DYNAMIC_COPY);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Particle),
+                              (void *) offsetof(Particle, position));
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(Particle),
+                              (void *) offsetof(Particle, age));
+
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Particle),
+                              (void *) offsetof(Particle, velocity));
+
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Particle),
+                              (void *) offsetof(Particle, lifetime));
+
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Particle),
+                              (void *) offsetof(Particle, generation));
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    current = 0;
+}
+
+void ParticleSystem::update()
+{
+    if (count == 0) {
+        return;
+    }
+
+    unsigned int next = 1 - current;
+
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    glBindVertexArray(vaos[current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[next]);
+
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, count);
+    glEndTransformFeedback();
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    current = next;
+}
+
+void ParticleSystem::draw() const
+{
+    if (count == 0) {
+        return;
+    }
+
+    glBindVertexArray(vaos[current]);
+    glDrawArrays(GL_POINTS, 0, count);
+    glBindVertexArray(0);
+}
+
+void ParticleSystem::release()
+{
+    if (vaos[0] != 0) {
+        glDeleteVertexArrays(2, vaos);
+        glDeleteBuffers(2, buffers);
+
+        vaos[0] = vaos[1] = 0;
+        buffers[0] = buffers[1] = 0;
+        count = 0;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include "ShaderProgram.h"
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// State of one particle, laid out as the update and draw shaders read it.
+// A particle is alive while 0 <= age < lifetime. generation tells the
+// update shader's emitter which spawn the particle stems from.
+struct Particle
+{
+    glm::vec3 position;
+    float age;
+    glm::vec3 velocity;
+    float lifetime;
+    float generation;
+};
+
+// Fixed pool of particles that lives in GPU memory only. update() runs a
+// vertex shader over every particle with rasterization off and captures
+// its outputs with transform feedback into the second of two buffers,
+// which then becomes the current one. The shader emits, integrates and
+// retires particles itself; the CPU only sets its emitter uniforms.
+// Needs nothing beyond GL 3.3, so it runs under Mesa's llvmpipe too.
+class ParticleSystem
+{
+public:
+    // The varyings an update program must capture, in Particle's order.
+    static const std::vector<const char *> &varyings();
+
+    ParticleSystem() : buffers {0, 0}, vaos {0, 0}, current {0}, count {0} {}
+
+    // Allocates particles, starting out as given.
+    void create(const std::vector<Particle> &particles);
+
+    // Steps every particle once with the update program in use.
+    void update();
+
+    // Draws the live particles as points with the program in use.
+    void draw() const;
+
+    unsigned int size() const { return count; }
+
+    // Frees the GL objects; needs the context that created them.
+    void release();
+
+private:
+    GLuint buffers[2];
+    GLuint vaos[2];
+    unsigned int current;
+    unsigned int count;
+};
+
+
+#endif
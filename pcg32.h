@@ -0,0 +1,71 @@
+#ifndef PCG32_H
+#define PCG32_H
+
+#include <cstdint>
+
+
+// PCG32 (XSH-RR) random number generator: 64 bits of state, 32-bit
+// output, a few instructions per number. Generators seeded alike but with
+// different stream numbers produce independent sequences, so every
+// subsystem can draw from its own stream without disturbing the others.
+class Pcg32
+{
+public:
+    explicit Pcg32(uint64_t seed = 0, uint64_t stream = 0)
+    {
+        reseed(seed, stream);
+    }
+
+    void reseed(uint64_t seed, uint64_t stream)
+    {
+        state = 0;
+        increment = (stream << 1) | 1;
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next()
+    {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+
+        uint32_t xorshifted = (uint32_t) (((old >> 18) ^ old) >> 27);
+        uint32_t rotation = (uint32_t) (old >> 59);
+
+        return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+    }
+
+    // Uniform in [0, bound), without modulo bias.
+    uint32_t below(uint32_t bound)
+    {
+        uint32_t threshold = -bound % bound;
+
+        for (;;) {
+            uint32_t r = next();
+
+            if (r >= threshold) {
+                return r % bound;
+            }
+        }
+    }
+
+    // Uniform in [min, max], both inclusive.
+    int range(int min, int max)
+    {
+        return min + (int) below((uint32_t) (max - min + 1));
+    }
+
+    // Uniform in [0, 1).
+    float uniform()
+    {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    uint64_t state;
+    uint64_t increment;
+};
+
+
+#endif
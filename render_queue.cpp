@@ -0,0 +1,289 @@
+#include "render_queue.h"
+
+#include "instance_buffer.h"
+#include "mesh.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+// Key fields, most significant first; the pass takes the top two bits.
+static const unsigned int PASS_SHIFT = 62;
+static const unsigned int PROGRAM_BITS = 6;
+static const unsigned int MATERIAL_BITS = 16;
+static const unsigned int VAO_BITS = 16;
+static const unsigned int DEPTH_BITS = 24;
+
+static const uint64_t DEPTH_MAX = (1ULL << DEPTH_BITS) - 1;
+
+// Binds a draw needs.
+static const unsigned int BIND_PROGRAM = 1;
+static const unsigned int BIND_MATERIAL = 2;
+static const unsigned int BIND_VAO = 4;
+
+static uint64_t field(uint64_t value, unsigned int bits)
+{
+    return value & ((1ULL << bits) - 1);
+}
+
+RenderQueue::RenderQueue()
+{
+    begin(glm::vec3(0.0f), 1.0f);
+}
+
+void RenderQueue::begin(const glm::vec3 &camera_position, float far_plane)
+{
+    this->camera_position = camera_position;
+    depth_scale = DEPTH_MAX / far_plane;
+
+    commands.clear();
+    order.clear();
+
+    std::memset(pass_start, 0, sizeof(pass_start));
+    std::memset(&submitted, 0, sizeof(submitted));
+    std::memset(&executed, 0, sizeof(executed));
+
+    triangles = 0;
+    full_triangles = 0;
+}
+
+void RenderQueue::submit(RenderPass pass,
+                         const ShaderProgram &program,
+                         UniformHandle<glm::mat4> model_uniform,
+                         const Mesh &mesh,
+                         const glm::mat4 &model,
+                         unsigned int lod)
+{
+    DrawCommand command;
+    command.model = model;
+    command.program = &program;
+    command.mesh = &mesh;
+    command.instances = nullptr;
+    command.first_instance = 0;
+    command.instance_count = 1;
+    command.lod = std::min(lod, (unsigned int) mesh.lods.size() - 1);
+    command.model_uniform = model_uniform;
+    command.pass = pass;
+
+    float depth = glm::distance(glm::vec3(model[3]), camera_position);
+
+    SortEntry entry = {key_of(command, depth), (uint32_t) commands.size()};
+    order.push_back(entry);
+    commands.push_back(command);
+}
+
+void RenderQueue::submit_instanced(RenderPass pass,
+                                   const ShaderProgram &program,
+                                   const Mesh &mesh,
+                                   const InstanceBuffer &instances,
+                                   unsigned int first,
+                                   unsigned int count,
+                                   unsigned int lod)
+{
+    if (count == 0) {
+        return;
+    }
+
+    DrawCommand command;
+    command.program = &program;
+    command.mesh = &mesh;
+    command.instances = &instances;
+    command.first_instance = first;
+    command.instance_count = count;
+    command.lod = std::min(lod, (unsigned int) mesh.lods.size() - 1);
+    command.pass = pass;
+
+    SortEntry entry = {key_of(command, 0.0f), (uint32_t) commands.size()};
+    order.push_back(entry);
+    commands.push_back(command);
+}
+
+uint64_t RenderQueue::key_of(const DrawCommand &command, float depth) const
+{
+    uint64_t program = field(command.program->GetProgram(), PROGRAM_BITS);
+    uint64_t material = command.mesh->textures.empty() ?
+            0 : field(command.mesh->textures[0].id, MATERIAL_BITS);
+    uint64_t vao = field(command.mesh->VAO, VAO_BITS);
+
+    uint64_t quantised = std::min((uint64_t) std::max(depth * depth_scale,
+                                                      0.0f),
+                                  DEPTH_MAX);
+
+    uint64_t key = (uint64_t) command.pass << PASS_SHIFT;
+
+    if (command.pass == RENDER_PASS_BLENDED) {
+        key |= (DEPTH_MAX - quantised) <<
+               (PROGRAM_BITS + MATERIAL_BITS + VAO_BITS);
+        key |= program << (MATERIAL_BITS + VAO_BITS);
+        key |= material << VAO_BITS;
+        key |= vao;
+
+    } else {
+        key |= program << (MATERIAL_BITS + VAO_BITS + DEPTH_BITS);
+        key |= material << (VAO_BITS + DEPTH_BITS);
+        key |= vao << DEPTH_BITS;
+        key |= quantised;
+    }
+
+    return key;
+}
+
+void RenderQueue::sort()
+{
+    // What the unsorted order would have cost.
+    BoundState state = {nullptr, nullptr, 0};
+
+    for (auto &entry: order) {
+        const DrawCommand &command = commands[entry.command];
+        count_binds(binds_needed(state, command), command, submitted);
+    }
+
+    // Stable LSD radix sort, a byte per pass. Bytes that every key shares
+    // are skipped, which for a frame's keys is most of them.
+    unsigned int histograms[8][256];
+    std::memset(histograms, 0, sizeof(histograms));
+
+    for (auto &entry: order) {
+        for (unsigned int digit = 0; digit < 8; digit++) {
+            histograms[digit][(entry.key >> (8 * digit)) & 0xff]++;
+        }
+    }
+
+    scratch.resize(order.size());
+
+    for (unsigned int digit = 0; digit < 8; digit++) {
+        unsigned int *count = histograms[digit];
+        unsigned int shift = 8 * digit;
+
+        if (order.empty() or
+                count[(order[0].key >> shift) & 0xff] == order.size()) {
+
+            continue;
+        }
+
+        unsigned int offset = 0;
+
+        for (unsigned int byte = 0; byte < 256; byte++) {
+            unsigned int n = count[byte];
+            count[byte] = offset;
+            offset += n;
+        }
+
+        for (auto &entry: order) {
+            scratch[count[(entry.key >> shift) & 0xff]++] = entry;
+        }
+
+        order.swap(scratch);
+    }
+
+    // Passes are the top bits, so each is one run of the sorted order.
+    unsigned int i = 0;
+
+    for (unsigned int pass = 0; pass <= RENDER_PASS_BLENDED; pass++) {
+        pass_start[pass] = i;
+
+        while (i < order.size() and (order[i].key >> PASS_SHIFT) == pass) {
+            i++;
+        }
+    }
+
+    pass_start[RENDER_PASS_BLENDED + 1] = i;
+}
+
+void RenderQueue::execute(RenderPass pass)
+{
+    // Whatever ran before may have changed any of it.
+    BoundState state = {nullptr, nullptr, 0};
+
+    for (unsigned int i = pass_start[pass]; i < pass_start[pass + 1]; i++) {
+        const DrawCommand &command = commands[order[i].command];
+        const Mesh &mesh = *command.mesh;
+
+        unsigned int binds = binds_needed(state, command);
+        count_binds(binds, command, executed);
+
+        if (binds & BIND_PROGRAM) {
+            command.program->StartUseShader();
+        }
+
+        if (binds & BIND_MATERIAL) {
+            mesh.BindTextures(*command.program);
+        }
+
+        if (binds & BIND_VAO) {
+            glBindVertexArray(mesh.VAO);
+        }
+
+        const MeshLod &lod = mesh.lods[command.lod];
+        const void *first_index = (const void *) (lod.first *
+                                                  sizeof(unsigned int));
+
+        if (command.instances != nullptr) {
+            mesh.BindInstanceMatrices(command.instances->id(),
+                                      command.first_instance);
+            glDrawElementsInstanced(GL_TRIANGLES,
+                                    lod.count,
+                                    GL_UNSIGNED_INT,
+                                    first_index,
+                                    command.instance_count);
+
+        } else {
+            command.program->SetUniform(command.model_uniform, command.model);
+            glDrawElements(GL_TRIANGLES,
+                           lod.count,
+                           GL_UNSIGNED_INT,
+                           first_index);
+        }
+
+        triangles += (unsigned long) lod.count / 3 * command.instance_count;
+        full_triangles += (unsigned long) mesh.lods[0].count / 3 *
+                          command.instance_count;
+    }
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+unsigned int RenderQueue::binds_needed(BoundState &state,
+                                       const DrawCommand &command)
+{
+    unsigned int binds = 0;
+
+    if (command.program != state.program) {
+        state.program = command.program;
+        binds |= BIND_PROGRAM;
+    }
+
+    // Sampler uniforms belong to the program, so a new program needs the
+    // material set up again even if the textures are bound already.
+    if ((binds & BIND_PROGRAM) or state.material == nullptr or
+            not command.mesh->SameTextures(*state.material)) {
+
+        state.material = command.mesh;
+        binds |= BIND_MATERIAL;
+    }
+
+    if (command.mesh->VAO != state.vao) {
+        state.vao = command.mesh->VAO;
+        binds |= BIND_VAO;
+    }
+
+    return binds;
+}
+
+void RenderQueue::count_binds(unsigned int binds,
+                              const DrawCommand &command,
+                              StateChanges &changes)
+{
+    if (binds & BIND_PROGRAM) {
+        changes.programs++;
+    }
+
+    if (binds & BIND_MATERIAL) {
+        changes.textures += command.mesh->textures.size();
+    }
+
+    if (binds & BIND_VAO) {
+        changes.vaos++;
+    }
+}
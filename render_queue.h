@@ -0,0 +1,143 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class InstanceBuffer;
+class Mesh;
+
+
+// Passes run in this order. The skybox is drawn between the two, so that
+// blended draws mix with it.
+enum RenderPass
+{
+    RENDER_PASS_OPAQUE,
+    RENDER_PASS_BLENDED
+};
+
+// GL state changes a frame's draws cost: programs made current, textures
+// bound and vertex arrays bound.
+struct StateChanges
+{
+    unsigned int programs;
+    unsigned int textures;
+    unsigned int vaos;
+};
+
+// The 3D draws of a frame. Systems submit them in any order, one per mesh,
+// and they are issued sorted by a 64-bit key:
+//
+//   opaque:  pass | program | material | VAO | depth
+//   blended: pass | inverted depth | program | material | VAO
+//
+// Opaque draws are grouped by GL state and go front to back within a
+// group, blended draws go back to front. The key fields are truncated GL
+// names and only decide the order; execution tracks the real state and
+// skips binds that wouldn't change it. All storage is kept between frames.
+class RenderQueue
+{
+public:
+    RenderQueue();
+
+    // Drops last frame's draws. Depth is the distance from camera_position,
+    // quantised over [0, far_plane].
+    void begin(const glm::vec3 &camera_position, float far_plane);
+
+    // One mesh placed by model, which program reads from model_uniform,
+    // at level of detail lod or the coarsest the mesh has.
+    void submit(RenderPass pass,
+                const ShaderProgram &program,
+                UniformHandle<glm::mat4> model_uniform,
+                const Mesh &mesh,
+                const glm::mat4 &model,
+                unsigned int lod);
+
+    // Instances first to first + count - 1 of instances, which must already
+    // be uploaded. A batch has no single depth and sorts as if at the
+    // camera.
+    void submit_instanced(RenderPass pass,
+                          const ShaderProgram &program,
+                          const Mesh &mesh,
+                          const InstanceBuffer &instances,
+                          unsigned int first,
+                          unsigned int count,
+                          unsigned int lod);
+
+    // Radix-sorts the draws by key.
+    void sort();
+
+    // Issues the sorted draws of pass.
+    void execute(RenderPass pass);
+
+    // State changes the draws would have cost in submission order.
+    const StateChanges &submitted_changes() const { return submitted; }
+
+    // State changes execute() has made since begin().
+    const StateChanges &executed_changes() const { return executed; }
+
+    // Triangles execute() has drawn since begin(), and how many the same
+    // draws would have had at full detail.
+    unsigned long triangles_drawn() const { return triangles; }
+    unsigned long full_detail_triangles() const { return full_triangles; }
+
+private:
+    struct DrawCommand
+    {
+        glm::mat4 model;
+        const ShaderProgram *program;
+        const Mesh *mesh;
+        const InstanceBuffer *instances;
+        unsigned int first_instance;
+        unsigned int instance_count;
+        unsigned int lod;
+        UniformHandle<glm::mat4> model_uniform;
+        RenderPass pass;
+    };
+
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t command;
+    };
+
+    // What is bound while a sequence of draws runs.
+    struct BoundState
+    {
+        const ShaderProgram *program;
+        const Mesh *material;
+        GLuint vao;
+    };
+
+    uint64_t key_of(const DrawCommand &command, float depth) const;
+
+    static unsigned int binds_needed(BoundState &state,
+                                     const DrawCommand &command);
+
+    static void count_binds(unsigned int binds,
+                            const DrawCommand &command,
+                            StateChanges &changes);
+
+    glm::vec3 camera_position;
+    float depth_scale;
+
+    std::vector<DrawCommand> commands;
+    std::vector<SortEntry> order;
+    std::vector<SortEntry> scratch;
+
+    // Where each pass's draws start in order, and where the last ends.
+    unsigned int pass_start[RENDER_PASS_BLENDED + 2];
+
+    StateChanges submitted;
+    StateChanges executed;
+
+    unsigned long triangles;
+    unsigned long full_triangles;
+};
+
+
+#endif
@@ -0,0 +1,222 @@
+#include "scenario.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+static const char *TYPE_NAMES[OBJ_TYPE_COUNT] =
+{
+    "ASTEROID1",
+    "ASTEROID2",
+    "PLASM_BALL",
+    "DUST",
+    "E45",
+    "WRAITH",
+    "VULCAN",
+    "EXPLOSION",
+    "ASTEROID_FRAGMENT"
+};
+
+Scenario::Scenario() : ship_interval {2.0f},
+                       ship_burst {1},
+                       ships {E45, WRAITH, E45, WRAITH, VULCAN},
+                       asteroid_interval {2.0f},
+                       asteroid_burst {1},
+                       asteroids {ASTEROID1, ASTEROID2},
+                       dust_interval {0.1f},
+                       dust_burst {1},
+                       spawn_spread {20},
+                       auto_fire_interval {0.0f},
+                       auto_fire_burst {0}
+{
+    lifetimes[ASTEROID1] = 10.0f;
+    lifetimes[ASTEROID2] = 10.0f;
+    lifetimes[PLASM_BALL] = 1.0f;
+    lifetimes[DUST] = 1.0f;
+    lifetimes[E45] = 10.0f;
+    lifetimes[WRAITH] = 10.0f;
+    lifetimes[VULCAN] = 10.0f;
+    lifetimes[EXPLOSION] = 0.3f;
+    lifetimes[ASTEROID_FRAGMENT] = 0.3f;
+}
+
+ModelHandle model_of(ObjTypes type)
+{
+    switch (type) {
+    case E45:
+        return E45_MODEL;
+
+    case WRAITH:
+        return WRAITH_MODEL;
+
+    case VULCAN:
+        return VULCAN_MODEL;
+
+    case ASTEROID1:
+        return ASTEROID1_MODEL;
+
+    case ASTEROID2:
+        return ASTEROID2_MODEL;
+
+    default:
+        return SPHERE_MODEL;
+    }
+}
+
+static bool parse_type(const std::string &name, ObjTypes &type)
+{
+    for (int t = 0; t < OBJ_TYPE_COUNT; t++) {
+        if (name == TYPE_NAMES[t]) {
+            type = (ObjTypes) t;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool parse_float(const std::string &text, float &value)
+{
+    char *end;
+    value = std::strtof(text.c_str(), &end);
+
+    return not text.empty() and *end == '\0' and value >= 0.0f;
+}
+
+static bool parse_count(const std::string &text, unsigned int &value)
+{
+    char *end;
+    long count = std::strtol(text.c_str(), &end, 10);
+
+    value = (unsigned int) count;
+    return not text.empty() and *end == '\0' and count >= 0;
+}
+
+// Reads a list of type names, all of which must be among allowed.
+static bool parse_mix(const std::string &text,
+                      std::vector<ObjTypes> &mix,
+                      std::initializer_list<ObjTypes> allowed)
+{
+    std::istringstream words(text);
+    std::string name;
+
+    mix.clear();
+
+    while (words >> name) {
+        ObjTypes type;
+
+        if (not parse_type(name, type) or
+                std::find(allowed.begin(), allowed.end(), type) ==
+                        allowed.end()) {
+
+            return false;
+        }
+
+        mix.push_back(type);
+    }
+
+    return not mix.empty();
+}
+
+static std::string trim(const std::string &text)
+{
+    const char *space = " \t\r";
+
+    size_t begin = text.find_first_not_of(space);
+    if (begin == std::string::npos) {
+        return "";
+    }
+
+    size_t end = text.find_last_not_of(space);
+    return text.substr(begin, end - begin + 1);
+}
+
+bool Scenario::load(const char *path)
+{
+    std::ifstream file(path);
+
+    if (not file) {
+        std::cerr << "Scenario " << path << ": can't open" << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(file, line)) {
+        line_number++;
+        line = trim(line.substr(0, line.find('#')));
+
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        std::string key = trim(line.substr(0, equals));
+        std::string value = equals == std::string::npos ?
+                "" : trim(line.substr(equals + 1));
+
+        unsigned int spread;
+        ObjTypes type;
+        bool ok;
+
+        if (key == "ship_interval") {
+            ok = parse_float(value, ship_interval);
+
+        } else if (key == "ship_burst") {
+            ok = parse_count(value, ship_burst);
+
+        } else if (key == "ships") {
+            ok = parse_mix(value, ships, {E45, WRAITH, VULCAN});
+
+        } else if (key == "asteroid_interval") {
+            ok = parse_float(value, asteroid_interval);
+
+        } else if (key == "asteroid_burst") {
+            ok = parse_count(value, asteroid_burst);
+
+        } else if (key == "asteroids") {
+            ok = parse_mix(value, asteroids, {ASTEROID1, ASTEROID2});
+
+        } else if (key == "dust_interval") {
+            ok = parse_float(value, dust_interval);
+
+        } else if (key == "dust_burst") {
+            ok = parse_count(value, dust_burst);
+
+        } else if (key == "spawn_spread") {
+            ok = parse_count(value, spread);
+            spawn_spread = spread;
+
+        } else if (key == "auto_fire_interval") {
+            ok = parse_float(value, auto_fire_interval);
+
+        } else if (key == "auto_fire_burst") {
+            ok = parse_count(value, auto_fire_burst);
+
+        } else if (key.compare(0, 9, "lifetime.") == 0 and
+                parse_type(key.substr(9), type)) {
+
+            ok = parse_float(value, lifetimes[type]);
+
+        } else {
+            std::cerr << "Scenario " << path << ":" << line_number
+                      << ": unknown key " << key << std::endl;
+            return false;
+        }
+
+        if (not ok) {
+            std::cerr << "Scenario " << path << ":" << line_number
+                      << ": bad value for " << key << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "entity_store.h"
+
+#include <vector>
+
+
+// Spawn cadence, entity mix, lifetimes and player auto-fire. The default
+// is the stock game; load() overrides it from a scenario file so that
+// workloads can be scaled without rebuilding.
+//
+// A scenario file has one "key = value" per line, "#" starts a comment,
+// and keys left out keep their stock value:
+//
+//     ship_interval = 2            seconds between ship spawns
+//     ship_burst = 1               ships per spawn
+//     ships = E45 WRAITH VULCAN    types spawned in turn
+//     asteroid_interval, asteroid_burst, asteroids    the same for asteroids
+//     dust_interval, dust_burst    the same for the GPU dust particles
+//     spawn_spread = 20            spawn x and y lie in [-spread, spread]
+//     auto_fire_interval = 0       seconds between player volleys, 0 is off
+//     auto_fire_burst = 0          plasm balls per volley
+//     lifetime.E45 = 10            seconds a type lives, for any type
+struct Scenario
+{
+    float ship_interval;
+    unsigned int ship_burst;
+    std::vector<ObjTypes> ships;
+
+    float asteroid_interval;
+    unsigned int asteroid_burst;
+    std::vector<ObjTypes> asteroids;
+
+    float dust_interval;
+    unsigned int dust_burst;
+
+    int spawn_spread;
+
+    float auto_fire_interval;
+    unsigned int auto_fire_burst;
+
+    // Indexed by ObjTypes.
+    float lifetimes[OBJ_TYPE_COUNT];
+
+    Scenario();
+
+    // Reads path over the current values. Prints what is wrong and returns
+    // false if the file can't be read or has an error.
+    bool load(const char *path);
+};
+
+// Model the renderer draws an entity type with.
+ModelHandle model_of(ObjTypes type);
+
+
+#endif
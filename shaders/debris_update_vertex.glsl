@@ -0,0 +1,87 @@
+#version 330 core
+
+// Steps one particle of asteroid debris; the outputs are captured as its
+// new state.
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in float age;
+layout (location = 2) in vec3 velocity;
+layout (location = 3) in float lifetime;
+layout (location = 4) in float generation;
+
+out vec3 outPosition;
+out float outAge;
+out vec3 outVelocity;
+out float outLifetime;
+out float outGeneration;
+
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    float time;
+};
+
+// Seconds since the previous update.
+uniform float dt;
+
+// The latest shatterings as (position, time); a negative time marks a
+// slot never used. DEBRIS_BURSTS is defined by the program that loads
+// this shader. Each slot owns a run of particlesPerBurst particles, which
+// fly out at up to speed for up to debrisLifetime seconds.
+uniform vec4 bursts[DEBRIS_BURSTS];
+uniform int particlesPerBurst;
+uniform float speed;
+uniform float debrisLifetime;
+
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// Uniform in [0, 1); advances state.
+float random(inout uint state)
+{
+    state = hash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+void main()
+{
+    outPosition = position + velocity * dt;
+    outAge = age + dt;
+    outVelocity = velocity;
+    outLifetime = lifetime;
+    outGeneration = generation;
+
+    vec4 burst = bursts[min(gl_VertexID / particlesPerBurst,
+                            DEBRIS_BURSTS - 1)];
+
+    // The slot holds a burst this particle hasn't come from yet: start
+    // over from it, as far along as the burst is by now. The burst's time
+    // is its identity.
+    if (burst.w >= 0.0 && burst.w != generation) {
+        uint state = hash(uint(gl_VertexID) * 0x9e3779b9U ^
+                          floatBitsToUint(burst.w));
+
+        // Uniform over the sphere of directions.
+        float z = 2.0 * random(state) - 1.0;
+        float angle = 6.2831853 * random(state);
+        vec3 direction = vec3(sqrt(1.0 - z * z) * vec2(cos(angle),
+                                                       sin(angle)),
+                              z);
+
+        outVelocity = direction * speed * mix(0.2, 1.0, random(state));
+        outLifetime = debrisLifetime * mix(0.5, 1.0, random(state));
+        outAge = max(time - burst.w, 0.0);
+        outPosition = burst.xyz + outVelocity * outAge;
+        outGeneration = burst.w;
+    }
+}
@@ -0,0 +1,68 @@
+#version 330 core
+
+// Steps one dust speck; the outputs are captured as its new state.
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in float age;
+layout (location = 2) in vec3 velocity;
+layout (location = 3) in float lifetime;
+layout (location = 4) in float generation;
+
+out vec3 outPosition;
+out float outAge;
+out vec3 outVelocity;
+out float outLifetime;
+out float outGeneration;
+
+// Seconds since the previous update.
+uniform float dt;
+
+// Specks appear at random x and y in [-spread, spread] at depth
+// spawnDepth and fly along z at speed for speckLifetime seconds.
+uniform float spread;
+uniform float spawnDepth;
+uniform float speed;
+uniform float speckLifetime;
+
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// Uniform in [0, 1); advances state.
+float random(inout uint state)
+{
+    state = hash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+void main()
+{
+    outPosition = position + velocity * dt;
+    outAge = age + dt;
+    outVelocity = velocity;
+    outLifetime = lifetime;
+    outGeneration = generation;
+
+    // A speck that has run out is born again right away, keeping what is
+    // left of its age, so that specks appear at an even rate. Specks that
+    // were never born (generation -1) are timed the same way.
+    if (outAge >= lifetime) {
+        outAge = mod(outAge - lifetime, speckLifetime);
+        outGeneration = generation + 1.0;
+
+        uint state = hash(uint(gl_VertexID) * 0x9e3779b9U ^
+                          uint(outGeneration));
+
+        vec2 xy = spread * (2.0 * vec2(random(state), random(state)) - 1.0);
+
+        outVelocity = vec3(0.0, 0.0, speed);
+        outLifetime = speckLifetime;
+        outPosition = vec3(xy, spawnDepth) + outVelocity * outAge;
+    }
+}
@@ -1,12 +0,0 @@
-#version 330 core
-
-out vec4 FragColor;
-
-in vec2 TexCoords;
-
-uniform sampler2D texture_diffuse1;
-
-void main()
-{    
-    FragColor = vec4(0.71f, 0.086f, 0.03f, 1.0f);
-}
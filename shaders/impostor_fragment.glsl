@@ -0,0 +1,41 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec3 QuadPosition;
+flat in vec3 SphereCenter;
+flat in float SphereRadius;
+
+uniform vec3 color;
+
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    float time;
+};
+
+void main()
+{
+    // Nearest hit of the ray from the camera through this fragment.
+    vec3 ray = normalize(QuadPosition);
+    float b = dot(ray, SphereCenter);
+    float c = dot(SphereCenter, SphereCenter) - SphereRadius * SphereRadius;
+    float discriminant = b * b - c;
+
+    if (discriminant < 0.0) {
+        discard;
+    }
+
+    vec3 hit = ray * (b - sqrt(discriminant));
+    vec3 normal = (hit - SphereCenter) / SphereRadius;
+
+    vec4 clip = projection * vec4(hit, 1.0);
+    gl_FragDepth = 0.5 * clip.z / clip.w + 0.5;
+
+    // Glow: the colour whitens towards the silhouette.
+    float rim = 1.0 - max(dot(normal, -ray), 0.0);
+    FragColor = vec4(mix(color, vec3(1.0), rim * rim), 1.0);
+}
@@ -0,0 +1,49 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 5) in mat4 instanceModel;
+
+// Sphere centred at the instance's translation with the instance's scale
+// as radius, drawn as one camera-facing quad that covers its silhouette.
+out vec3 QuadPosition;
+flat out vec3 SphereCenter;
+flat out float SphereRadius;
+
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    float time;
+};
+
+void main()
+{
+    vec3 center = vec3(view * vec4(instanceModel[3].xyz, 1.0));
+    float radius = length(instanceModel[0].xyz);
+    float distance = length(center);
+
+    SphereCenter = center;
+    SphereRadius = radius;
+
+    // From inside the sphere there is no silhouette to cover.
+    if (distance <= radius) {
+        QuadPosition = center;
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    // The quad goes through the centre, perpendicular to the line of
+    // sight, where the cone of rays grazing the sphere is a circle.
+    vec3 forward = center / distance;
+    vec3 up = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) :
+                                      vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(forward, up));
+    up = cross(right, forward);
+
+    float halfSize = radius * distance /
+                     sqrt(distance * distance - radius * radius);
+
+    QuadPosition = center + halfSize * (aPos.x * right + aPos.y * up);
+    gl_Position = projection * vec4(QuadPosition, 1.0);
+}
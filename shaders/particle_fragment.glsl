@@ -0,0 +1,17 @@
+#version 330 core
+
+in float Alpha;
+out vec4 FragColor;
+
+uniform vec3 color;
+
+void main()
+{
+    // Round points.
+    vec2 offset = 2.0 * gl_PointCoord - 1.0;
+    if (dot(offset, offset) > 1.0) {
+        discard;
+    }
+
+    FragColor = vec4(color, Alpha);
+}
@@ -0,0 +1,41 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in float age;
+layout (location = 3) in float lifetime;
+layout (location = 4) in float generation;
+
+out float Alpha;
+
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    float time;
+};
+
+// Diameter of a particle in world units, and the on-screen size in pixels
+// of one unit at a distance of one unit.
+uniform float size;
+uniform float pixelScale;
+
+// 1 fades particles out over their lifetime, 0 keeps them opaque.
+uniform float fading;
+
+void main()
+{
+    // Particles never born or already retired land outside the clip
+    // volume.
+    if (generation < 0.0 || age < 0.0 || age >= lifetime) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+        Alpha = 0.0;
+        return;
+    }
+
+    gl_Position = viewProjection * vec4(position, 1.0);
+    gl_PointSize = max(size * pixelScale / gl_Position.w, 1.0);
+    Alpha = 1.0 - fading * age / lifetime;
+}
@@ -1,12 +1,18 @@
 #version 330 core
 
-layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 texel;
+layout (location = 2) in vec3 textColor;
+
 out vec2 TexCoords;
+out vec3 TextColor;
 
 uniform mat4 projection;
+uniform sampler2D text;
 
 void main()
 {
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
-    TexCoords = vertex.zw;
+    gl_Position = projection * vec4(position, 0.0, 1.0);
+    TexCoords = texel / vec2(textureSize(text, 0));
+    TextColor = textColor;
 }
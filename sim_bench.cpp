@@ -0,0 +1,286 @@
+#include "allocation_counter.h"
+#include "frame_stats.h"
+#include "input_recording.h"
+#include "scenario.h"
+#include "simulation.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+
+// Steps the gameplay simulation without a window or GL context and reports
+// the tick rate. The player auto-fires at a starship so that the
+// collision path is exercised. The position update pass is then timed on
+// its own against the final world.
+//
+// --record file saves the bench's input so that the game can replay it;
+// --replay file runs a recorded session instead (with its seed and tick
+// length, and without the bench's own auto-fire) and reports the
+// distribution of per-tick times. The health top-ups are part of the
+// recorded input, so a bench recording replays to the same game.
+//
+// --scenario file spawns and auto-fires as the scenario says, on top of
+// the bench's own fire, and reports the per-tick time distribution along
+// with how many entities were alive.
+//
+// --threads N spreads the position passes and hit tests over N threads
+// (0: one per hardware thread); by default the bench runs on one.
+//
+// Built with -DCOUNT_ALLOCATIONS=ON it also counts heap allocations after
+// the first tenth of the run, once every pool has grown to the working set,
+// and fails if the steady-state loop allocated at all.
+
+int main(int argc, char** argv)
+{
+    long ticks = 1000000;
+    int fire_interval = 6;
+    float tick_rate = 1.0f / SIM_TICK;
+    uint64_t seed = 0;
+    const char *record_path = nullptr;
+    const char *replay_path = nullptr;
+    const char *scenario_path = nullptr;
+    int threads = 1;
+
+    // Positional arguments, with the options allowed anywhere among them.
+    std::vector<const char *> args;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--seed") == 0 and i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+
+        } else if (std::strcmp(argv[i], "--record") == 0 and i + 1 < argc) {
+            record_path = argv[++i];
+
+        } else if (std::strcmp(argv[i], "--replay") == 0 and i + 1 < argc) {
+            replay_path = argv[++i];
+
+        } else if (std::strcmp(argv[i], "--scenario") == 0 and
+                i + 1 < argc) {
+
+            scenario_path = argv[++i];
+
+        } else if (std::strcmp(argv[i], "--threads") == 0 and
+                i + 1 < argc) {
+
+            threads = std::atoi(argv[++i]);
+
+        } else if (std::strncmp(argv[i], "--", 2) == 0) {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.size() > 0) {
+        ticks = std::atol(args[0]);
+
+        if (ticks <= 0) {
+            std::cerr << "Tick count must be positive: " << args[0]
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.size() > 1) {
+        fire_interval = std::atoi(args[1]);
+    }
+
+    if (args.size() > 2) {
+        tick_rate = std::atof(args[2]);
+
+        // Written so that NaN fails too.
+        if (not (tick_rate > 0.0f)) {
+            std::cerr << "Tick rate must be positive: " << args[2]
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    InputRecording recording;
+    bool replaying = replay_path != nullptr;
+
+    if (replaying) {
+        if (not recording.load(replay_path)) {
+            std::cerr << "Failed to load input recording " << replay_path
+                      << std::endl;
+            return 1;
+        }
+
+        ticks = recording.ticks.size();
+        tick_rate = 1.0f / recording.tick;
+        seed = recording.seed;
+
+    } else if (record_path != nullptr) {
+        recording.seed = seed;
+        recording.tick = 1.0f / tick_rate;
+        recording.ticks.reserve(ticks);
+    }
+
+    std::cout << "Seed: " << seed << std::endl;
+
+    Simulation simulation(seed);
+
+    if (scenario_path != nullptr) {
+        Scenario scenario;
+
+        if (not scenario.load(scenario_path)) {
+            return 1;
+        }
+
+        simulation.set_scenario(scenario);
+        std::cout << "Scenario: " << scenario_path << std::endl;
+    }
+
+    JobSystem jobs(threads);
+
+    if (jobs.thread_count() > 1) {
+        simulation.set_job_system(&jobs);
+    }
+
+    std::cout << "Threads: " << jobs.thread_count() << std::endl;
+
+    const EntityStore *stores[] = {
+        &simulation.starships,
+        &simulation.plasm_balls,
+        &simulation.enemy_plasm_balls,
+        &simulation.explosions,
+        &simulation.asteroids
+    };
+
+    auto count_entities = [&]() {
+        unsigned int entities = 0;
+
+        for (auto store: stores) {
+            entities += store->size();
+        }
+
+        return entities;
+    };
+
+    long warmup_ticks = ticks / 10;
+    unsigned long warmup_allocations = allocation_count();
+
+    bool timing_ticks = replaying or scenario_path != nullptr;
+    unsigned int peak_entities = 0;
+
+    std::vector<float> tick_ms;
+    if (timing_ticks) {
+        tick_ms.reserve(ticks);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (long tick = 0; tick < ticks; tick++) {
+        if (tick == warmup_ticks) {
+            warmup_allocations = allocation_count();
+        }
+
+        TickInput input = TickInput();
+
+        if (replaying) {
+            input = recording.ticks[tick];
+
+        } else {
+            // Keep the player alive so that every tick runs the full
+            // pipeline, however many hits a dense scenario lands in one.
+            input.flags |= INPUT_KEEP_ALIVE;
+
+            if (fire_interval > 0 and tick % fire_interval == 0 and
+                    not simulation.starships.empty()) {
+
+                glm::vec3 target = simulation.starships.real_coords(0);
+
+                input.flags |= INPUT_FIRE;
+                input.fire_direction = glm::normalize(
+                        target - simulation.player_position);
+            }
+        }
+
+        if (record_path != nullptr and not replaying) {
+            recording.ticks.push_back(input);
+        }
+
+        auto tick_start = std::chrono::steady_clock::now();
+
+        simulation.apply(input);
+        simulation.step(1.0f / tick_rate);
+        simulation.sounds.clear();
+
+        if (timing_ticks) {
+            auto tick_end = std::chrono::steady_clock::now();
+            tick_ms.push_back(std::chrono::duration<float, std::milli>(
+                    tick_end - tick_start).count());
+
+            peak_entities = std::max(peak_entities, count_entities());
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    unsigned long steady_allocations = allocation_count() -
+                                       warmup_allocations;
+
+    std::cout << "Ticks: " << ticks << std::endl;
+    std::cout << "Simulated time: " << simulation.time() << " s" << std::endl;
+    std::cout << "Wall time: " << seconds << " s" << std::endl;
+    std::cout << "Ticks per second: " << ticks / seconds << std::endl;
+    std::cout << "Score: " << simulation.score << std::endl;
+
+    if (timing_ticks) {
+        print_frame_stats("Ticks", summarize_frame_times(tick_ms));
+        std::cout << "Entities: " << count_entities() << " at the end, "
+                  << peak_entities << " at peak" << std::endl;
+    }
+
+    if (record_path != nullptr and not replaying) {
+        if (not recording.save(record_path)) {
+            std::cerr << "Failed to save input recording " << record_path
+                      << std::endl;
+            return 1;
+        }
+
+        std::cout << "Recorded " << ticks << " ticks to " << record_path
+                  << std::endl;
+    }
+
+    if (counting_allocations()) {
+        std::cout << "Steady-state allocations: " << steady_allocations
+                  << " in " << ticks - warmup_ticks << " ticks"
+                  << std::endl;
+    }
+
+    // Explosions don't move.
+    unsigned int entities = count_entities() - simulation.explosions.size();
+
+    // About a second of passes, however big the world grew.
+    const long passes = std::max(1000L, 100000000L / (long) (entities + 100));
+
+    start = std::chrono::steady_clock::now();
+
+    for (long pass = 0; pass < passes; pass++) {
+        simulation.update_positions();
+    }
+
+    end = std::chrono::steady_clock::now();
+    double pass_ns = std::chrono::duration<double, std::nano>(
+            end - start).count() / passes;
+
+    std::cout << "Position pass: " << pass_ns << " ns for "
+              << entities << " entities" << std::endl;
+
+    if (counting_allocations() and steady_allocations > 0) {
+        std::cerr << "The steady-state loop allocated" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,893 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+// Room reserved up front per entity class, and for the per-tick scratch
+// arrays sized by it. Nothing in a tick allocates until a class outgrows
+// this, which takes unusually heavy spawn rates.
+static const unsigned int ENTITY_CAPACITY = 256;
+static const unsigned int ENTITY_CLASSES = 5;
+
+// Smallest share of a loop worth handing to another thread. Moving an
+// entity takes about a nanosecond, testing a target against the player's
+// fire a good deal longer.
+static const unsigned int POSITION_GRAIN = 4096;
+static const unsigned int COLLISION_GRAIN = 64;
+
+// Stream numbers of the per-subsystem generators. Nothing draws from the
+// dust and effects streams any more, but the numbers stay put so that the
+// other streams, and with them recorded sessions, replay unchanged.
+enum RandomStream
+{
+    SHIP_STREAM,
+    ASTEROID_STREAM,
+    DUST_STREAM,
+    EFFECTS_STREAM,
+    AUTO_FIRE_STREAM
+};
+
+Simulation::Simulation(uint64_t seed) : starships {ENTITY_CAPACITY},
+                           plasm_balls {ENTITY_CAPACITY},
+                           enemy_plasm_balls {ENTITY_CAPACITY},
+                           explosions {ENTITY_CAPACITY},
+                           asteroids {ENTITY_CAPACITY},
+                           debris_burst_count {0},
+                           player_position {glm::vec3(0.0f, 0.0f, 3.0f)},
+                           score {0},
+                           health {100},
+                           game_over {false},
+                           game_over_timestamp {0.0f},
+                           elapsed_time {0.0},
+                           current_time {0.0f},
+                           key_a_timestamp {0.0f},
+                           key_d_timestamp {0.0f},
+                           prev_model_timestamp {-1.0f},
+                           prev_asteroid_timestamp {0.0f},
+                           prev_auto_fire_timestamp {0.0f},
+                           type_of_starship {0},
+                           type_of_asteroid {0},
+                           expiry_wheel {SIM_TICK,
+                                         ENTITY_CLASSES * ENTITY_CAPACITY},
+                           plasm_ball_grid {BROADPHASE_CELL_SIZE},
+                           plasm_ball_reach {0.0f},
+                           swept_hits {swept_hit_kernel()},
+                           collision_scratch(1),
+                           jobs {nullptr}
+{
+    for (auto &burst: debris_bursts) {
+        burst.position = glm::vec3(0.0f);
+        burst.time = -1.0f;
+    }
+
+    collision_scratch[0].hits.reserve(ENTITY_CAPACITY);
+    events.reserve(ENTITY_CAPACITY);
+    hit_start.reserve(ENTITY_CAPACITY + 1);
+    hit_balls.reserve(ENTITY_CAPACITY);
+
+    sounds.reserve(ENTITY_CAPACITY);
+    expired.reserve(ENTITY_CLASSES * ENTITY_CAPACITY);
+    plasm_ball_mid_x.reserve(ENTITY_CAPACITY);
+    plasm_ball_mid_y.reserve(ENTITY_CAPACITY);
+    plasm_ball_mid_z.reserve(ENTITY_CAPACITY);
+
+    reseed(seed);
+}
+
+void Simulation::reseed(uint64_t seed)
+{
+    this->seed = seed;
+
+    ship_rng.reseed(seed, SHIP_STREAM);
+    asteroid_rng.reseed(seed, ASTEROID_STREAM);
+    auto_fire_rng.reseed(seed, AUTO_FIRE_STREAM);
+}
+
+// Most entities of a kind alive at once when count of them appear every
+// interval seconds and live for lifetime, with a tick of slack.
+static unsigned int population(unsigned int count,
+                               float interval,
+                               float lifetime)
+{
+    interval = std::max(interval, SIM_TICK);
+    return count * ((unsigned int) std::ceil(lifetime / interval) + 1);
+}
+
+static float longest_lifetime(const Scenario &scenario,
+                              const std::vector<ObjTypes> &mix)
+{
+    float lifetime = 0.0f;
+
+    for (auto type: mix) {
+        lifetime = std::max(lifetime, scenario.lifetimes[type]);
+    }
+
+    return lifetime;
+}
+
+void Simulation::set_scenario(const Scenario &scenario)
+{
+    this->scenario = scenario;
+
+    unsigned int ships = population(scenario.ship_burst,
+                                    scenario.ship_interval,
+                                    longest_lifetime(scenario,
+                                                     scenario.ships));
+    unsigned int rocks = population(scenario.asteroid_burst,
+                                    scenario.asteroid_interval,
+                                    longest_lifetime(scenario,
+                                                     scenario.asteroids));
+    unsigned int shots = ENTITY_CAPACITY;
+    if (scenario.auto_fire_interval > 0.0f) {
+        shots += population(scenario.auto_fire_burst,
+                            scenario.auto_fire_interval,
+                            scenario.lifetimes[PLASM_BALL]);
+    }
+
+    // A ship has at most one shot of its own in flight; every kill leaves
+    // an explosion.
+    unsigned int capacities[] = {
+        ships, shots, ships, ships + rocks, rocks
+    };
+
+    EntityStore *stores[] = {
+        &starships,
+        &plasm_balls,
+        &enemy_plasm_balls,
+        &explosions,
+        &asteroids
+    };
+
+    unsigned int total = 0;
+
+    for (unsigned int k = 0; k < ENTITY_CLASSES; k++) {
+        unsigned int capacity = std::max(capacities[k], ENTITY_CAPACITY);
+
+        stores[k]->reserve(capacity);
+        total += capacity;
+    }
+
+    expiry_wheel.reserve(total);
+    expired.reserve(total);
+    sounds.reserve(total);
+    plasm_ball_mid_x.reserve(shots);
+    plasm_ball_mid_y.reserve(shots);
+    plasm_ball_mid_z.reserve(shots);
+
+    unsigned int targets = std::max(ships, rocks) + 1;
+    hit_start.reserve(targets);
+    hit_balls.reserve(shots);
+
+    for (auto &scratch: collision_scratch) {
+        scratch.hits.reserve(shots);
+    }
+
+    events.reserve(std::max(ships + rocks, shots));
+}
+
+void Simulation::set_job_system(JobSystem *jobs)
+{
+    this->jobs = jobs;
+
+    unsigned int threads = jobs != nullptr ? jobs->thread_count() : 1;
+    unsigned int capacity = collision_scratch[0].hits.capacity();
+
+    collision_scratch.resize(threads);
+
+    for (auto &scratch: collision_scratch) {
+        scratch.hits.reserve(capacity);
+    }
+}
+
+template <typename Body>
+void Simulation::parallel_for(unsigned int count,
+                              unsigned int grain,
+                              const Body &body)
+{
+    if (jobs != nullptr) {
+        jobs->parallel_for(count, grain, body);
+
+    } else if (count > 0) {
+        body(0, count, 0);
+    }
+}
+
+void Simulation::move_left()
+{
+    if ((current_time - key_a_timestamp) > 0.15f and
+            player_position.x >= 0) {
+
+        shift_lane(-15.0f);
+        key_a_timestamp = current_time;
+    }
+}
+
+void Simulation::move_right()
+{
+    if ((current_time - key_d_timestamp) > 0.15f and
+            player_position.x <= 0) {
+
+        shift_lane(15.0f);
+        key_d_timestamp = current_time;
+    }
+}
+
+void Simulation::shift_lane(float offset)
+{
+    player_position.x += offset;
+
+    // Player plasm balls are anchored to the player's lane. Move them along
+    // now so that the jump is not swept as motion on the next tick.
+    for (auto &x: plasm_balls.real_x) {
+        x += offset;
+    }
+}
+
+void Simulation::fire(const glm::vec3 &direction)
+{
+    if (game_over) {
+        return;
+    }
+
+    launch_plasm_ball(direction);
+
+    sounds.push_back(SOUND_SHOT);
+}
+
+void Simulation::launch_plasm_ball(const glm::vec3 &direction)
+{
+    unsigned int i = spawn(plasm_balls,
+                           direction,
+                           PLASM_BALL,
+                           SPHERE_MODEL);
+
+    plasm_balls.place(i, glm::vec3(player_position.x, 0.0f, 0.0f));
+}
+
+void Simulation::auto_fire()
+{
+    if (scenario.auto_fire_interval <= 0.0f or
+            scenario.auto_fire_burst == 0 or
+            current_time - prev_auto_fire_timestamp <=
+                    scenario.auto_fire_interval or
+            game_over) {
+
+        return;
+    }
+
+    for (unsigned int k = 0; k < scenario.auto_fire_burst; k++) {
+        glm::vec3 direction(0.0f, 0.0f, -1.0f);
+
+        if (not starships.empty()) {
+            unsigned int i = auto_fire_rng.below(starships.size());
+            glm::vec3 offset = starships.real_coords(i) - player_position;
+
+            if (offset.z < 0.0f) {
+                direction = glm::normalize(offset);
+            }
+        }
+
+        launch_plasm_ball(direction);
+    }
+
+    // One sound per volley, however many balls it has.
+    sounds.push_back(SOUND_SHOT);
+    prev_auto_fire_timestamp = current_time;
+}
+
+void Simulation::apply(const TickInput &input)
+{
+    if (input.flags & INPUT_KEEP_ALIVE) {
+        health = std::numeric_limits<int>::max() / 2;
+    }
+
+    if (input.flags & INPUT_MOVE_LEFT) {
+        move_left();
+    }
+
+    if (input.flags & INPUT_MOVE_RIGHT) {
+        move_right();
+    }
+
+    if (input.flags & INPUT_FIRE) {
+        fire(input.fire_direction);
+    }
+}
+
+void Simulation::step(float dt)
+{
+    elapsed_time += dt;
+    current_time = (float) elapsed_time;
+
+    spawn_objects();
+    auto_fire();
+    clear_objects();
+
+    // Move everything first: targets are tested against the segment each
+    // ball swept during this tick.
+    save_positions();
+    update_positions();
+    build_plasm_ball_grid();
+
+    process_starships();
+    process_asteroids();
+    process_enemy_plasm_balls();
+    apply_events();
+
+    compact_objects();
+
+    if (health <= 0 and not game_over) {
+        health = 0;
+        game_over = true;
+        game_over_timestamp = current_time;
+
+        sounds.push_back(SOUND_LARGE_EXPLOSION);
+    }
+}
+
+static glm::vec3 random_spawn_coords(Pcg32 &rng, int spread)
+{
+    return glm::vec3(
+        (float) rng.range(-spread, spread),
+        (float) rng.range(-spread, spread),
+        0.0f
+    );
+}
+
+void Simulation::spawn_burst(EntityStore &store,
+                             const std::vector<ObjTypes> &mix,
+                             unsigned int &next_type,
+                             unsigned int count,
+                             Pcg32 &rng,
+                             float z)
+{
+    for (unsigned int k = 0; k < count; k++) {
+        ObjTypes type = mix[next_type];
+        glm::vec3 coords = random_spawn_coords(rng, scenario.spawn_spread);
+
+        unsigned int i = spawn(store, coords, type, model_of(type));
+        store.place(i, glm::vec3(coords.x, coords.y, z));
+
+        next_type = (next_type + 1) % mix.size();
+    }
+}
+
+void Simulation::spawn_objects()
+{
+    // Add new starships.
+    if (current_time - prev_model_timestamp > scenario.ship_interval) {
+        unsigned int first = starships.size();
+
+        spawn_burst(starships,
+                    scenario.ships,
+                    type_of_starship,
+                    scenario.ship_burst,
+                    ship_rng,
+                    -100.0f);
+
+        for (unsigned int i = first; i < starships.size(); i++) {
+            starships.last_shot_timestamp[i] = current_time + 1.0f;
+        }
+
+        prev_model_timestamp = current_time;
+    }
+
+    // Add new asteroids.
+    if (current_time - prev_asteroid_timestamp > scenario.asteroid_interval) {
+        spawn_burst(asteroids,
+                    scenario.asteroids,
+                    type_of_asteroid,
+                    scenario.asteroid_burst,
+                    asteroid_rng,
+                    -110.0f);
+
+        prev_asteroid_timestamp = current_time;
+    }
+}
+
+unsigned int Simulation::spawn(EntityStore &store,
+                               const glm::vec3 &coords,
+                               ObjTypes type,
+                               ModelHandle model)
+{
+    unsigned int i = store.add(current_time, coords, type, model);
+
+    expiry_wheel.schedule(Expiry {&store, store.handle(i)},
+                          (double) current_time + scenario.lifetimes[type]);
+
+    return i;
+}
+
+void Simulation::clear_objects()
+{
+    expiry_wheel.advance(current_time, expired);
+
+    // Entities dropped earlier, e.g. when shot, no longer resolve.
+    for (auto &expiry: expired) {
+        unsigned int i;
+
+        if (expiry.store->find(expiry.handle, i)) {
+            expiry.store->remove(i);
+        }
+    }
+
+    expired.clear();
+
+    starships.compact();
+    plasm_balls.compact();
+    enemy_plasm_balls.compact();
+    explosions.compact();
+    asteroids.compact();
+}
+
+void Simulation::save_positions()
+{
+    starships.save_positions();
+    plasm_balls.save_positions();
+    enemy_plasm_balls.save_positions();
+    asteroids.save_positions();
+}
+
+// The passes below only touch flat float arrays, one output column per
+// loop, so that the compiler can vectorise each loop with just a couple of
+// run-time overlap checks between the columns.
+
+// Each pass moves the entities in [begin, end), so that a store can be
+// split between threads.
+
+// Keeps x and y and flies along z from start_z at speed.
+static void move_along_z(EntityStore &store,
+                         unsigned int begin,
+                         unsigned int end,
+                         float current_time,
+                         float start_z,
+                         float speed)
+{
+    const float *appearance_timestamp = store.appearance_timestamp.data();
+    float *real_z = store.real_z.data();
+
+    std::copy(store.coords_x.begin() + begin, store.coords_x.begin() + end,
+              store.real_x.begin() + begin);
+    std::copy(store.coords_y.begin() + begin, store.coords_y.begin() + end,
+              store.real_y.begin() + begin);
+
+    for (unsigned int i = begin; i < end; i++) {
+        real_z[i] = start_z + speed * (current_time - appearance_timestamp[i]);
+    }
+}
+
+// Player fire leaves the player's lane along the aim direction, which is
+// stored as the spawn coords.
+static void move_plasm_balls(EntityStore &plasm_balls,
+                             unsigned int begin,
+                             unsigned int end,
+                             float current_time,
+                             float player_x)
+{
+    const float *appearance_timestamp =
+            plasm_balls.appearance_timestamp.data();
+    const float *coords_x = plasm_balls.coords_x.data();
+    const float *coords_y = plasm_balls.coords_y.data();
+    const float *coords_z = plasm_balls.coords_z.data();
+    float *real_x = plasm_balls.real_x.data();
+    float *real_y = plasm_balls.real_y.data();
+    float *real_z = plasm_balls.real_z.data();
+
+    for (unsigned int i = begin; i < end; i++) {
+        float t = current_time - appearance_timestamp[i];
+        real_x[i] = player_x + 200 * coords_x[i] * t;
+    }
+
+    for (unsigned int i = begin; i < end; i++) {
+        float t = current_time - appearance_timestamp[i];
+        real_y[i] = 200 * coords_y[i] * t;
+    }
+
+    for (unsigned int i = begin; i < end; i++) {
+        float t = current_time - appearance_timestamp[i];
+        float z = coords_z[i];
+        real_z[i] = 150 * z / std::abs(z) * t;
+    }
+}
+
+// Enemy fire homes in on the player's current lane.
+static void move_enemy_plasm_balls(EntityStore &enemy_plasm_balls,
+                                   unsigned int begin,
+                                   unsigned int end,
+                                   float current_time,
+                                   float player_x)
+{
+    const float *appearance_timestamp =
+            enemy_plasm_balls.appearance_timestamp.data();
+    const float *coords_x = enemy_plasm_balls.coords_x.data();
+    const float *coords_y = enemy_plasm_balls.coords_y.data();
+    const float *coords_z = enemy_plasm_balls.coords_z.data();
+    float *real_x = enemy_plasm_balls.real_x.data();
+    float *real_y = enemy_plasm_balls.real_y.data();
+    float *real_z = enemy_plasm_balls.real_z.data();
+
+    for (unsigned int i = begin; i < end; i++) {
+        float t = current_time - appearance_timestamp[i];
+        float x = coords_x[i];
+        real_x[i] = x - 2 * (x - player_x) * t;
+    }
+
+    for (unsigned int i = begin; i < end; i++) {
+        float t = current_time - appearance_timestamp[i];
+        float y = coords_y[i];
+        real_y[i] = y - 2 * y * t;
+    }
+
+    for (unsigned int i = begin; i < end; i++) {
+        float t = current_time - appearance_timestamp[i];
+        float z = coords_z[i];
+        real_z[i] = z - 2 * (z - 3.0f) * t;
+    }
+}
+
+void Simulation::update_positions()
+{
+    float t = current_time;
+    float player_x = player_position.x;
+
+    parallel_for(starships.size(), POSITION_GRAIN,
+            [&](unsigned int begin, unsigned int end, unsigned int) {
+        move_along_z(starships, begin, end, t, -100.0f, 20.0f);
+    });
+
+    parallel_for(asteroids.size(), POSITION_GRAIN,
+            [&](unsigned int begin, unsigned int end, unsigned int) {
+        move_along_z(asteroids, begin, end, t, -110.0f, 30.0f);
+    });
+
+    parallel_for(plasm_balls.size(), POSITION_GRAIN,
+            [&](unsigned int begin, unsigned int end, unsigned int) {
+        move_plasm_balls(plasm_balls, begin, end, t, player_x);
+    });
+
+    parallel_for(enemy_plasm_balls.size(), POSITION_GRAIN,
+            [&](unsigned int begin, unsigned int end, unsigned int) {
+        move_enemy_plasm_balls(enemy_plasm_balls, begin, end, t, player_x);
+    });
+}
+
+void Simulation::add_explosion(const glm::vec3 &coords)
+{
+    spawn(explosions, coords, EXPLOSION, SPHERE_MODEL);
+}
+
+void Simulation::shatter_asteroid(const glm::vec3 &coords)
+{
+    DebrisBurst &burst = debris_bursts[debris_burst_count % DEBRIS_BURSTS];
+
+    burst.position = coords;
+    burst.time = current_time;
+    debris_burst_count++;
+}
+
+void Simulation::build_plasm_ball_grid()
+{
+    unsigned int n = plasm_balls.size();
+
+    plasm_ball_mid_x.resize(n);
+    plasm_ball_mid_y.resize(n);
+    plasm_ball_mid_z.resize(n);
+    plasm_ball_reach = 0.0f;
+
+    // Index each swept segment by its midpoint; reach is the longest
+    // half-segment, so a query widened by it finds every segment that can
+    // touch a target.
+    for (unsigned int i = 0; i < n; i++) {
+        glm::vec3 p0 = plasm_balls.prev_coords(i);
+        glm::vec3 p1 = plasm_balls.real_coords(i);
+        glm::vec3 mid = 0.5f * (p0 + p1);
+
+        plasm_ball_mid_x[i] = mid.x;
+        plasm_ball_mid_y[i] = mid.y;
+        plasm_ball_mid_z[i] = mid.z;
+
+        plasm_ball_reach = std::max(plasm_ball_reach,
+                                    0.5f * glm::distance(p0, p1));
+    }
+
+    plasm_ball_grid.build(plasm_ball_mid_x.data(),
+                          plasm_ball_mid_y.data(),
+                          plasm_ball_mid_z.data(),
+                          n);
+}
+
+template <typename OnHit>
+static void for_each_bit(uint32_t mask, OnHit on_hit)
+{
+    for (unsigned int k = 0; mask != 0; k++, mask >>= 1) {
+        if (mask & 1) {
+            on_hit(k);
+        }
+    }
+}
+
+template <typename OnHit>
+void Simulation::for_each_plasm_ball_hit(const EntityStore &targets,
+                                         unsigned int i,
+                                         float radius,
+                                         CollisionScratch &scratch,
+                                         OnHit on_hit)
+{
+    glm::vec3 target0 = targets.prev_coords(i);
+    glm::vec3 target1 = targets.real_coords(i);
+
+    unsigned int n = plasm_balls.size();
+
+    // Few balls: test them straight from the store, a block at a time.
+    if (n < SpatialHash::LINEAR_SCAN_LIMIT) {
+        for (unsigned int base = 0; base < n; base += COLLISION_BLOCK) {
+            unsigned int count = std::min(n - base,
+                                          (unsigned int) COLLISION_BLOCK);
+
+            uint32_t mask = swept_hits(target0,
+                                       target1,
+                                       radius,
+                                       &plasm_balls.prev_x[base],
+                                       &plasm_balls.prev_y[base],
+                                       &plasm_balls.prev_z[base],
+                                       &plasm_balls.real_x[base],
+                                       &plasm_balls.real_y[base],
+                                       &plasm_balls.real_z[base],
+                                       count);
+
+            for_each_bit(mask, [&](unsigned int k) {
+                on_hit(base + k);
+            });
+        }
+
+        return;
+    }
+
+    // Otherwise pack the broadphase candidates into blocks.
+    glm::vec3 center = 0.5f * (target0 + target1);
+    float reach = radius + 0.5f * glm::distance(target0, target1) +
+            plasm_ball_reach;
+
+    unsigned int count = 0;
+
+    auto flush = [&]() {
+        uint32_t mask = swept_hits(target0,
+                                   target1,
+                                   radius,
+                                   scratch.candidate_x0,
+                                   scratch.candidate_y0,
+                                   scratch.candidate_z0,
+                                   scratch.candidate_x1,
+                                   scratch.candidate_y1,
+                                   scratch.candidate_z1,
+                                   count);
+
+        for_each_bit(mask, [&](unsigned int k) {
+            on_hit(scratch.candidate_ids[k]);
+        });
+
+        count = 0;
+    };
+
+    plasm_ball_grid.for_each_near(center, reach, [&](unsigned int j) {
+        scratch.candidate_ids[count] = j;
+        scratch.candidate_x0[count] = plasm_balls.prev_x[j];
+        scratch.candidate_y0[count] = plasm_balls.prev_y[j];
+        scratch.candidate_z0[count] = plasm_balls.prev_z[j];
+        scratch.candidate_x1[count] = plasm_balls.real_x[j];
+        scratch.candidate_y1[count] = plasm_balls.real_y[j];
+        scratch.candidate_z1[count] = plasm_balls.real_z[j];
+        count++;
+
+        if (count == COLLISION_BLOCK) {
+            flush();
+        }
+    });
+
+    if (count > 0) {
+        flush();
+    }
+}
+
+template <typename Radius>
+void Simulation::find_plasm_ball_hits(const EntityStore &targets,
+                                      Radius radius)
+{
+    for (auto &scratch: collision_scratch) {
+        scratch.hits.clear();
+    }
+
+    // Only reads positions, so targets can be tested in any order.
+    parallel_for(targets.size(), COLLISION_GRAIN,
+            [&](unsigned int begin, unsigned int end, unsigned int thread) {
+
+        CollisionScratch &scratch = collision_scratch[thread];
+
+        for (unsigned int i = begin; i < end; i++) {
+            for_each_plasm_ball_hit(targets, i, radius(i), scratch,
+                    [&](unsigned int j) {
+
+                scratch.hits.push_back(PlasmBallHit {i, j});
+            });
+        }
+    });
+
+    // Group the hits by target with a counting sort. All hits on a target
+    // come from one thread, in the order they were found, so the result is
+    // the same however the targets were shared out.
+    unsigned int n = targets.size();
+    hit_start.assign(n + 1, 0);
+
+    for (auto &scratch: collision_scratch) {
+        for (auto &hit: scratch.hits) {
+            hit_start[hit.target + 1]++;
+        }
+    }
+
+    for (unsigned int i = 0; i < n; i++) {
+        hit_start[i + 1] += hit_start[i];
+    }
+
+    hit_balls.resize(hit_start[n]);
+
+    // Scatter using hit_start as the write cursor, then shift it back.
+    for (auto &scratch: collision_scratch) {
+        for (auto &hit: scratch.hits) {
+            hit_balls[hit_start[hit.target]++] = hit.ball;
+        }
+    }
+
+    for (unsigned int i = n; i > 0; i--) {
+        hit_start[i] = hit_start[i - 1];
+    }
+
+    hit_start[0] = 0;
+}
+
+void Simulation::process_starships()
+{
+    find_plasm_ball_hits(starships, [](unsigned int) {
+        return DIST;
+    });
+
+    for (unsigned int i = 0; i < starships.size(); i++) {
+        glm::vec3 real_coords = starships.real_coords(i);
+
+        if (real_coords.z < 0.0f and
+                current_time - starships.last_shot_timestamp[i] > 1.5f and
+                not game_over) {
+
+            spawn(enemy_plasm_balls,
+                  real_coords,
+                  PLASM_BALL,
+                  SPHERE_MODEL);
+
+            starships.last_shot_timestamp[i] = current_time;
+        }
+
+        if (real_coords.z > 0.0f and not game_over) {
+            if ((player_position.x >= 0 and real_coords.x >= 0) or
+                    (player_position.x <= 0 and real_coords.x <= 0)) {
+
+                glm::vec3 explosion(real_coords.x,
+                                    real_coords.y,
+                                    real_coords.z - 6.0f);
+
+                events.player_damage.push_back(
+                        PlayerDamagedEvent {10, NO_ENTITY});
+                events.ships_destroyed.push_back(
+                        ShipDestroyedEvent {i, explosion});
+            }
+        }
+
+        int points = starships.obj_type[i] == VULCAN ? 15 : 10;
+
+        for (unsigned int k = hit_start[i]; k < hit_start[i + 1]; k++) {
+            events.hits.push_back(HitEvent {hit_balls[k], points});
+            events.ships_destroyed.push_back(
+                    ShipDestroyedEvent {i, real_coords});
+        }
+    }
+}
+
+void Simulation::process_asteroids()
+{
+    find_plasm_ball_hits(asteroids, [&](unsigned int i) {
+        return asteroids.obj_type[i] == ASTEROID2 ? DIST + 0.5f : DIST;
+    });
+
+    for (unsigned int i = 0; i < asteroids.size(); i++) {
+        glm::vec3 real_coords = asteroids.real_coords(i);
+
+        if (real_coords.z > 0.0f and not game_over) {
+            if ((player_position.x >= 0 and real_coords.x >= 0) or
+                    (player_position.x <= 0 and real_coords.x <= 0)) {
+
+                glm::vec3 explosion(real_coords.x,
+                                    real_coords.y,
+                                    real_coords.z - 6.0f);
+
+                events.player_damage.push_back(
+                        PlayerDamagedEvent {10, NO_ENTITY});
+                events.asteroids_shattered.push_back(
+                        AsteroidShatteredEvent {i, real_coords, explosion});
+            }
+        }
+
+        for (unsigned int k = hit_start[i]; k < hit_start[i + 1]; k++) {
+            events.hits.push_back(HitEvent {hit_balls[k], 5});
+            events.asteroids_shattered.push_back(
+                    AsteroidShatteredEvent {i, real_coords, real_coords});
+        }
+    }
+}
+
+void Simulation::process_enemy_plasm_balls()
+{
+    for (unsigned int i = 0; i < enemy_plasm_balls.size(); i++) {
+        if (enemy_plasm_balls.real_z[i] > 0.0f and not game_over) {
+            events.player_damage.push_back(PlayerDamagedEvent {5, i});
+        }
+    }
+}
+
+void Simulation::apply_events()
+{
+    int points = 0;
+    int damage = 0;
+    bool hit_by_enemy_fire = false;
+
+    for (auto &hit: events.hits) {
+        plasm_balls.remove(hit.plasm_ball);
+        points += hit.score;
+    }
+
+    for (auto &damaged: events.player_damage) {
+        if (damaged.enemy_plasm_ball != NO_ENTITY) {
+            enemy_plasm_balls.remove(damaged.enemy_plasm_ball);
+            hit_by_enemy_fire = true;
+        }
+
+        damage += damaged.damage;
+    }
+
+    score += points;
+    health -= damage;
+
+    for (auto &destroyed: events.ships_destroyed) {
+        starships.remove(destroyed.starship);
+        add_explosion(destroyed.explosion);
+    }
+
+    for (auto &shattered: events.asteroids_shattered) {
+        asteroids.remove(shattered.asteroid);
+        add_explosion(shattered.explosion);
+    }
+
+    for (auto &shattered: events.asteroids_shattered) {
+        shatter_asteroid(shattered.position);
+    }
+
+    // However many things blew up this tick, one sound of each kind.
+    if (not events.ships_destroyed.empty() or
+            not events.asteroids_shattered.empty()) {
+
+        sounds.push_back(SOUND_EXPLOSION);
+    }
+
+    if (hit_by_enemy_fire) {
+        sounds.push_back(SOUND_ENEMY_HIT);
+    }
+
+    events.clear();
+}
+
+void Simulation::compact_objects()
+{
+    starships.compact();
+    asteroids.compact();
+    plasm_balls.compact();
+    enemy_plasm_balls.compact();
+}
@@ -0,0 +1,265 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "collision.h"
+#include "entity_store.h"
+#include "gameplay_events.h"
+#include "input_recording.h"
+#include "job_system.h"
+#include "pcg32.h"
+#include "scenario.h"
+#include "spatial_hash.h"
+#include "timing_wheel.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// Gameplay state and rules, kept free of GL, GLFW and irrKlang so that it
+// can be stepped headless (benchmarks, CI) as well as from the game loop.
+
+#define DIST 2.5f
+#define SIM_TICK (1.0f / 60.0f)
+
+// Broadphase cell edge, the diameter of the largest target sphere.
+#define BROADPHASE_CELL_SIZE (2.0f * (DIST + 0.5f))
+
+// Asteroids shattered lately, kept for the renderer's debris particles.
+#define DEBRIS_BURSTS 16
+
+struct DebrisBurst
+{
+    glm::vec3 position;
+
+    // Simulation time of the shattering; negative for a slot never used.
+    float time;
+};
+
+// Sounds requested by the simulation, played by the frontend.
+enum SoundCue
+{
+    SOUND_SHOT,
+    SOUND_EXPLOSION,
+    SOUND_ENEMY_HIT,
+    SOUND_LARGE_EXPLOSION
+};
+
+class Simulation
+{
+public:
+    EntityStore starships;
+    EntityStore plasm_balls;
+    EntityStore enemy_plasm_balls;
+    EntityStore explosions;
+    EntityStore asteroids;
+
+    // Burst k of all those so far sits at k % DEBRIS_BURSTS. Dust and
+    // debris are purely visual and live on the GPU; the simulation only
+    // says where debris starts.
+    DebrisBurst debris_bursts[DEBRIS_BURSTS];
+    unsigned int debris_burst_count;
+
+    // Sounds emitted since the frontend last cleared the list.
+    std::vector<SoundCue> sounds;
+
+    // The player sits at the camera position and moves between three lanes.
+    glm::vec3 player_position;
+
+    int score;
+    int health;
+    bool game_over;
+    float game_over_timestamp;
+
+    // All randomness is drawn from streams derived from seed, so equal
+    // seeds and equal input give identical runs.
+    explicit Simulation(uint64_t seed = 0);
+
+    // Restarts every random stream from seed. Meant for before the first
+    // step.
+    void reseed(uint64_t seed);
+
+    uint64_t get_seed() const { return seed; }
+
+    // Spawns and auto-fires as scenario says from the next step on, and
+    // reserves room for the population it is expected to reach. Meant for
+    // before the first step; the stock scenario is the default.
+    void set_scenario(const Scenario &scenario);
+
+    const Scenario &get_scenario() const { return scenario; }
+
+    // Spreads the position passes and the hit tests over jobs' threads
+    // from the next step on; nullptr, the default, runs them on the
+    // calling thread. Results don't depend on the thread count.
+    void set_job_system(JobSystem *jobs);
+
+    // Advances the world by dt seconds.
+    void step(float dt);
+
+    // Lane changes, ignored for 0.15 s after the previous one.
+    void move_left();
+    void move_right();
+
+    // Launches a player plasm ball along the aim direction.
+    void fire(const glm::vec3 &direction);
+
+    // Health top-up, lane changes and shots of one tick's input, in that
+    // order. Looking around only moves the frontend's camera.
+    void apply(const TickInput &input);
+
+    // Evaluates the trajectory of every moving entity at the current time,
+    // one tight pass per entity class. step() calls it once per tick, after
+    // saving the previous positions; gameplay, collision and rendering only
+    // read the results.
+    void update_positions();
+
+    float time() const { return current_time; }
+
+    // Time of the previous tick blended with the current one, matching
+    // EntityStore::interpolated_coords() with the same alpha.
+    float interpolated_time(float alpha, float dt) const
+    {
+        return current_time - (1.0f - alpha) * dt;
+    }
+
+private:
+    void shift_lane(float offset);
+
+    // Adds an entity at the current time and schedules its expiry after
+    // the lifetime of its type.
+    unsigned int spawn(EntityStore &store,
+                       const glm::vec3 &coords,
+                       ObjTypes type,
+                       ModelHandle model);
+
+    void spawn_objects();
+
+    // Spawns count entities of the types in mix, taken in turn from
+    // next_type on, at random x and y and the given depth.
+    void spawn_burst(EntityStore &store,
+                     const std::vector<ObjTypes> &mix,
+                     unsigned int &next_type,
+                     unsigned int count,
+                     Pcg32 &rng,
+                     float z);
+
+    // The scenario's player auto-fire: volleys at random starships.
+    void auto_fire();
+    void launch_plasm_ball(const glm::vec3 &direction);
+
+    // Drops the entities whose lifetime has run out.
+    void clear_objects();
+    void save_positions();
+    void build_plasm_ball_grid();
+
+    // Runs body over [0, count) on the job system, if there is one.
+    template <typename Body>
+    void parallel_for(unsigned int count,
+                      unsigned int grain,
+                      const Body &body);
+
+    struct PlasmBallHit
+    {
+        unsigned int target;
+        unsigned int ball;
+    };
+
+    // Narrow-phase candidates, packed into blocks for the kernel, and the
+    // hits found, one set per thread.
+    struct CollisionScratch
+    {
+        unsigned int candidate_ids[COLLISION_BLOCK];
+        float candidate_x0[COLLISION_BLOCK];
+        float candidate_y0[COLLISION_BLOCK];
+        float candidate_z0[COLLISION_BLOCK];
+        float candidate_x1[COLLISION_BLOCK];
+        float candidate_y1[COLLISION_BLOCK];
+        float candidate_z1[COLLISION_BLOCK];
+
+        std::vector<PlasmBallHit> hits;
+    };
+
+    // Calls on_hit(j) for every player plasm ball j whose swept segment
+    // touches target i's sphere during this tick.
+    template <typename OnHit>
+    void for_each_plasm_ball_hit(const EntityStore &targets,
+                                 unsigned int i,
+                                 float radius,
+                                 CollisionScratch &scratch,
+                                 OnHit on_hit);
+
+    // Tests every target, with the sphere radius(i) for target i, against
+    // the player plasm balls in parallel and fills hit_start and hit_balls.
+    template <typename Radius>
+    void find_plasm_ball_hits(const EntityStore &targets, Radius radius);
+
+    // Collision passes; they only raise events.
+    void process_starships();
+    void process_asteroids();
+    void process_enemy_plasm_balls();
+
+    // Removes what the events destroyed, spawns their explosions and
+    // debris bursts, and updates score, health and sounds once each.
+    void apply_events();
+    void compact_objects();
+
+    void add_explosion(const glm::vec3 &coords);
+    void shatter_asteroid(const glm::vec3 &coords);
+
+    Scenario scenario;
+
+    // One stream per subsystem, so that e.g. changing how asteroids spawn
+    // doesn't shift where ships appear.
+    uint64_t seed;
+    Pcg32 ship_rng;
+    Pcg32 asteroid_rng;
+    Pcg32 auto_fire_rng;
+
+    // Accumulated in double so long headless runs don't drift.
+    double elapsed_time;
+    float current_time;
+    float key_a_timestamp;
+    float key_d_timestamp;
+
+    float prev_model_timestamp;
+    float prev_asteroid_timestamp;
+    float prev_auto_fire_timestamp;
+    unsigned int type_of_starship;
+    unsigned int type_of_asteroid;
+
+    struct Expiry
+    {
+        EntityStore *store;
+        EntityHandle handle;
+    };
+
+    // Every spawned entity, by the time it runs out. Entries of entities
+    // dropped before that are skipped when they come due.
+    TimingWheel<Expiry> expiry_wheel;
+    std::vector<Expiry> expired;
+
+    // Player plasm balls bucketed by the midpoint of the segment they swept
+    // this tick, rebuilt every tick.
+    SpatialHash plasm_ball_grid;
+    std::vector<float> plasm_ball_mid_x;
+    std::vector<float> plasm_ball_mid_y;
+    std::vector<float> plasm_ball_mid_z;
+    float plasm_ball_reach;
+
+    GameplayEvents events;
+
+    // Narrow phase, vectorised for the CPU we run on.
+    SweptHitKernel swept_hits;
+    std::vector<CollisionScratch> collision_scratch;
+
+    // Result of find_plasm_ball_hits(): target i was hit by the balls
+    // hit_balls[hit_start[i]] up to hit_balls[hit_start[i + 1]], in the
+    // order the serial search would find them.
+    std::vector<unsigned int> hit_start;
+    std::vector<unsigned int> hit_balls;
+
+    JobSystem *jobs;
+};
+
+
+#endif
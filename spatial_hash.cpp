@@ -0,0 +1,70 @@
+#include "spatial_hash.h"
+
+#include <algorithm>
+
+
+SpatialHash::SpatialHash(float cell_size) : inv_cell_size {1.0f / cell_size},
+                                            point_count {0},
+                                            bucket_mask {0}
+{
+}
+
+void SpatialHash::build(const float *x,
+                        const float *y,
+                        const float *z,
+                        unsigned int count)
+{
+    point_count = count;
+
+    if (count < LINEAR_SCAN_LIMIT) {
+        return;
+    }
+
+    // Keep the table at least twice the point count so buckets stay short.
+    unsigned int bucket_count = 64;
+    while (bucket_count < 2 * count) {
+        bucket_count *= 2;
+    }
+
+    bucket_mask = bucket_count - 1;
+
+    if (bucket_start.size() < bucket_count + 1) {
+        bucket_start.resize(bucket_count + 1);
+    }
+
+    if (point_keys.size() < count) {
+        point_keys.resize(count);
+        sorted_keys.resize(count);
+        sorted_ids.resize(count);
+    }
+
+    std::fill(bucket_start.begin(),
+              bucket_start.begin() + bucket_count + 1,
+              0);
+
+    for (unsigned int i = 0; i < count; i++) {
+        point_keys[i] = cell_key(cell_coord(x[i]),
+                                 cell_coord(y[i]),
+                                 cell_coord(z[i]));
+
+        bucket_start[bucket_of(point_keys[i]) + 1]++;
+    }
+
+    for (unsigned int b = 0; b < bucket_count; b++) {
+        bucket_start[b + 1] += bucket_start[b];
+    }
+
+    // Scatter using bucket_start as the write cursor, then shift it back.
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int k = bucket_start[bucket_of(point_keys[i])]++;
+
+        sorted_keys[k] = point_keys[i];
+        sorted_ids[k] = i;
+    }
+
+    for (unsigned int b = bucket_count; b > 0; b--) {
+        bucket_start[b] = bucket_start[b - 1];
+    }
+
+    bucket_start[0] = 0;
+}
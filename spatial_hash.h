@@ -0,0 +1,106 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+
+// Uniform grid over an unbounded world, stored as a hash table of cells.
+// build() buckets a set of points by cell with a counting sort, so a rebuild
+// is O(n) and stops allocating once the arrays have grown to the working set.
+// Queries visit only the points in the cells a sphere overlaps. Small sets
+// are not bucketed at all: below LINEAR_SCAN_LIMIT points a query simply
+// visits every point, which is cheaper than hashing.
+class SpatialHash
+{
+public:
+    static const unsigned int LINEAR_SCAN_LIMIT = 32;
+
+    explicit SpatialHash(float cell_size);
+
+    // Indexes count points given as separate coordinate arrays. Point ids
+    // passed to visitors are indices into these arrays.
+    void build(const float *x,
+               const float *y,
+               const float *z,
+               unsigned int count);
+
+    // Calls visit(id) for every indexed point lying in a cell overlapped by
+    // the sphere's bounding box. Each point is visited at most once; callers
+    // still have to do the exact distance test.
+    template <typename Visitor>
+    void for_each_near(const glm::vec3 &center,
+                       float radius,
+                       Visitor visit) const
+    {
+        if (point_count < LINEAR_SCAN_LIMIT) {
+            for (unsigned int id = 0; id < point_count; id++) {
+                visit(id);
+            }
+
+            return;
+        }
+
+        int min_x = cell_coord(center.x - radius);
+        int min_y = cell_coord(center.y - radius);
+        int min_z = cell_coord(center.z - radius);
+        int max_x = cell_coord(center.x + radius);
+        int max_y = cell_coord(center.y + radius);
+        int max_z = cell_coord(center.z + radius);
+
+        for (int cx = min_x; cx <= max_x; cx++) {
+            for (int cy = min_y; cy <= max_y; cy++) {
+                for (int cz = min_z; cz <= max_z; cz++) {
+                    uint64_t key = cell_key(cx, cy, cz);
+                    unsigned int bucket = bucket_of(key);
+
+                    for (unsigned int k = bucket_start[bucket];
+                            k < bucket_start[bucket + 1]; k++) {
+
+                        // Different cells may share a bucket.
+                        if (sorted_keys[k] == key) {
+                            visit(sorted_ids[k]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    int cell_coord(float v) const
+    {
+        return (int) std::floor(v * inv_cell_size);
+    }
+
+    static uint64_t cell_key(int x, int y, int z)
+    {
+        return ((uint64_t) (uint32_t) x & 0x1fffff) |
+               (((uint64_t) (uint32_t) y & 0x1fffff) << 21) |
+               (((uint64_t) (uint32_t) z & 0x1fffff) << 42);
+    }
+
+    unsigned int bucket_of(uint64_t key) const
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return (unsigned int) key & bucket_mask;
+    }
+
+    float inv_cell_size;
+
+    unsigned int point_count;
+    unsigned int bucket_mask;
+
+    std::vector<unsigned int> bucket_start;
+    std::vector<uint64_t> point_keys;
+    std::vector<uint64_t> sorted_keys;
+    std::vector<unsigned int> sorted_ids;
+};
+
+
+#endif
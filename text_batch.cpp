@@ -0,0 +1,177 @@
+#include "text_batch.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Decodes the UTF-8 sequence at text and moves text past it. Malformed
+// sequences come out as U+FFFD one byte at a time.
+static uint32_t next_code_point(const unsigned char *&text)
+{
+    static const uint32_t REPLACEMENT = 0xfffd;
+
+    uint32_t code = *text++;
+
+    if (code < 0x80) {
+        return code;
+    }
+
+    unsigned int length;
+    uint32_t minimum;
+
+    if ((code & 0xe0) == 0xc0) {
+        length = 1;
+        minimum = 0x80;
+        code &= 0x1f;
+
+    } else if ((code & 0xf0) == 0xe0) {
+        length = 2;
+        minimum = 0x800;
+        code &= 0x0f;
+
+    } else if ((code & 0xf8) == 0xf0) {
+        length = 3;
+        minimum = 0x10000;
+        code &= 0x07;
+
+    } else {
+        return REPLACEMENT;
+    }
+
+    const unsigned char *c = text;
+
+    for (unsigned int i = 0; i < length; i++, c++) {
+        if ((*c & 0xc0) != 0x80) {
+            return REPLACEMENT;
+        }
+
+        code = (code << 6) | (*c & 0x3f);
+    }
+
+    if (code < minimum or code > 0x10ffff or
+            (code >= 0xd800 and code < 0xe000)) {
+        return REPLACEMENT;
+    }
+
+    text = c;
+    return code;
+}
+
+void TextBatch::add(GlyphAtlas &atlas,
+                    const char *text,
+                    float x,
+                    float y,
+                    float size,
+                    const glm::vec3 &color)
+{
+    float scale = size / GlyphAtlas::PIXEL_SIZE;
+    const unsigned char *c = (const unsigned char *) text;
+
+    while (*c != '\0') {
+        const Glyph &glyph = atlas.glyph(next_code_point(c));
+
+        // Spaces and other blank glyphs only move the pen.
+        if (glyph.size.x > 0.0f and glyph.size.y > 0.0f) {
+            float left = x + glyph.bearing.x * scale;
+            float top = y + glyph.bearing.y * scale;
+            float right = left + glyph.size.x * scale;
+            float bottom = top - glyph.size.y * scale;
+
+            // Distance fields are stored top row first.
+            TextVertex top_left = {glm::vec2(left, top),
+                                   glyph.texel_min,
+                                   color};
+            TextVertex bottom_left = {glm::vec2(left, bottom),
+                                      glm::vec2(glyph.texel_min.x,
+                                                glyph.texel_max.y),
+                                      color};
+            TextVertex bottom_right = {glm::vec2(right, bottom),
+                                       glyph.texel_max,
+                                       color};
+            TextVertex top_right = {glm::vec2(right, top),
+                                    glm::vec2(glyph.texel_max.x,
+                                              glyph.texel_min.y),
+                                    color};
+
+            vertices.push_back(top_left);
+            vertices.push_back(bottom_left);
+            vertices.push_back(bottom_right);
+
+            vertices.push_back(top_left);
+            vertices.push_back(bottom_right);
+            vertices.push_back(top_right);
+        }
+
+        x += glyph.advance * scale;
+    }
+}
+
+void TextBatch::draw(const GlyphAtlas &atlas)
+{
+    if (vertices.empty()) {
+        return;
+    }
+
+    if (vao == 0) {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &buffer);
+
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex),
+                              (void *) offsetof(TextVertex, position));
+
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex),
+                              (void *) offsetof(TextVertex, texel));
+
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex),
+                              (void *) offsetof(TextVertex, color));
+
+    } else {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    }
+
+    unsigned int size = vertices.size();
+
+    if (size > capacity) {
+        capacity = capacity == 0 ? 1024 : capacity;
+        while (capacity < size) {
+            capacity *= 2;
+        }
+    }
+
+    // Orphaned first, as in InstanceBuffer::upload().
+    glBufferData(GL_ARRAY_BUFFER,
+                 capacity * sizeof(TextVertex),
+                 nullptr,
+                 GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    0,
+                    size * sizeof(TextVertex),
+                    vertices.data());
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas.id());
+
+    glDrawArrays(GL_TRIANGLES, 0, size);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextBatch::release()
+{
+    if (vao != 0) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &buffer);
+        vao = 0;
+        buffer = 0;
+        capacity = 0;
+    }
+}
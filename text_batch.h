@@ -0,0 +1,59 @@
+#ifndef TEXT_BATCH_H
+#define TEXT_BATCH_H
+
+#include "glyph_atlas.h"
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// Screen-space text of a whole frame. Strings are laid out on the CPU into
+// one list of glyph quads, which draw() streams into a vertex buffer and
+// draws with a single call. The colour travels with each vertex, so
+// strings of different colours still share the draw. Texture coordinates
+// are in texels, which stay valid when the atlas grows.
+class TextBatch
+{
+public:
+    TextBatch() : vao {0}, buffer {0}, capacity {0} {}
+
+    // Forgets the text of the previous frame.
+    void clear() { vertices.clear(); }
+
+    // Lays the UTF-8 string text out from (x, y), the left end of its
+    // baseline, at an em size of size pixels. Looking the glyphs up may
+    // add them to the atlas.
+    void add(GlyphAtlas &atlas,
+             const char *text,
+             float x,
+             float y,
+             float size,
+             const glm::vec3 &color);
+
+    // Draws everything added since clear(), with the atlas bound to unit
+    // 0, under whatever program is in use.
+    void draw(const GlyphAtlas &atlas);
+
+    // Frees the GL objects; needs the context that created them.
+    void release();
+
+private:
+    struct TextVertex
+    {
+        glm::vec2 position;
+        glm::vec2 texel;
+        glm::vec3 color;
+    };
+
+    std::vector<TextVertex> vertices;
+
+    GLuint vao;
+    GLuint buffer;
+    unsigned int capacity;
+};
+
+
+#endif
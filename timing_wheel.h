@@ -0,0 +1,218 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+
+// Hierarchical timing wheel. Items are scheduled with an absolute deadline
+// and handed back by advance() once the clock has passed it.
+//
+// Time is cut into ticks of a fixed resolution. The first level has one
+// slot per tick for the next WHEEL_SLOTS ticks, every further level has
+// slots WHEEL_SLOTS times coarser. An item goes to the finest level whose
+// span reaches its deadline, and drops a level each time the clock enters
+// the slot it sits in. Scheduling is O(1), and advance() costs O(expired)
+// plus the amortised cascading, independent of how many items are still
+// waiting. Deadlines past the top level wait in an overflow list that is
+// redistributed whenever the top level wraps.
+//
+// Entries live in a node pool and each slot is an intrusive list through
+// it, so scheduling and expiry only allocate when the pool has to grow
+// past the capacity given at construction.
+template <typename T>
+class TimingWheel
+{
+public:
+    static const unsigned int WHEEL_BITS = 6;
+    static const unsigned int WHEEL_SLOTS = 1 << WHEEL_BITS;
+    static const unsigned int WHEEL_LEVELS = 4;
+
+    TimingWheel(double resolution, unsigned int capacity)
+        : resolution {resolution},
+          current_tick {0},
+          free_node {NIL},
+          overflow {NIL},
+          slots(WHEEL_LEVELS * WHEEL_SLOTS, NIL)
+    {
+        nodes.reserve(capacity);
+    }
+
+    // Schedules item to expire once the clock is strictly past deadline.
+    void schedule(const T &item, double deadline)
+    {
+        uint32_t node;
+
+        if (free_node != NIL) {
+            node = free_node;
+            free_node = nodes[node].next;
+
+        } else {
+            node = nodes.size();
+            nodes.push_back(Node());
+        }
+
+        nodes[node].item = item;
+        nodes[node].deadline = deadline;
+        nodes[node].tick = tick_of(deadline);
+
+        insert(node);
+    }
+
+    // Moves the clock to now and appends every item whose deadline now has
+    // passed to expired.
+    void advance(double now, std::vector<T> &expired)
+    {
+        uint64_t target = tick_of(now);
+
+        // Every deadline in a tick before the target one lies before now.
+        for (; current_tick < target; current_tick++) {
+            cascade();
+
+            uint32_t &slot = slots[current_tick & SLOT_MASK];
+
+            while (slot != NIL) {
+                uint32_t node = slot;
+                slot = nodes[node].next;
+
+                expired.push_back(nodes[node].item);
+                release(node);
+            }
+        }
+
+        // The target tick is only partly over: compare exact deadlines.
+        cascade();
+
+        uint32_t *link = &slots[current_tick & SLOT_MASK];
+
+        while (*link != NIL) {
+            uint32_t node = *link;
+
+            if (now > nodes[node].deadline) {
+                *link = nodes[node].next;
+
+                expired.push_back(nodes[node].item);
+                release(node);
+
+            } else {
+                link = &nodes[node].next;
+            }
+        }
+    }
+
+    // Makes room for capacity pending items.
+    void reserve(unsigned int capacity)
+    {
+        nodes.reserve(capacity);
+    }
+
+private:
+    static const uint64_t SLOT_MASK = WHEEL_SLOTS - 1;
+    static const uint32_t NIL = 0xffffffff;
+
+    struct Node
+    {
+        T item;
+        double deadline;
+        uint64_t tick;
+        uint32_t next;
+    };
+
+    uint64_t tick_of(double time) const
+    {
+        return time > 0.0 ? (uint64_t) std::floor(time / resolution) : 0;
+    }
+
+    void push(uint32_t &list, uint32_t node)
+    {
+        nodes[node].next = list;
+        list = node;
+    }
+
+    void release(uint32_t node)
+    {
+        push(free_node, node);
+    }
+
+    void insert(uint32_t node)
+    {
+        uint64_t tick = nodes[node].tick > current_tick ? nodes[node].tick :
+                                                          current_tick;
+
+        // Finest level on which the deadline and the clock share the slot
+        // of every coarser level.
+        for (unsigned int level = 0; level < WHEEL_LEVELS; level++) {
+            unsigned int shift = level * WHEEL_BITS;
+
+            if ((tick >> (shift + WHEEL_BITS)) ==
+                    (current_tick >> (shift + WHEEL_BITS))) {
+
+                unsigned int index = (tick >> shift) & SLOT_MASK;
+                push(slots[level * WHEEL_SLOTS + index], node);
+                return;
+            }
+        }
+
+        push(overflow, node);
+    }
+
+    // Redistributes the coarse slots the clock has just entered, coarsest
+    // first, so that their items land on the finer levels before those
+    // are cascaded in turn. Repeating it within a tick finds them empty.
+    void cascade()
+    {
+        unsigned int top = 0;
+
+        while (top + 1 < WHEEL_LEVELS and
+                at_boundary((top + 1) * WHEEL_BITS)) {
+
+            top++;
+        }
+
+        if (at_boundary(WHEEL_LEVELS * WHEEL_BITS)) {
+            redistribute(overflow);
+        }
+
+        for (unsigned int level = top; level > 0; level--) {
+            unsigned int index =
+                    (current_tick >> (level * WHEEL_BITS)) & SLOT_MASK;
+
+            redistribute(slots[level * WHEEL_SLOTS + index]);
+        }
+    }
+
+    // Whether the clock sits on a multiple of 2^bits ticks.
+    bool at_boundary(unsigned int bits) const
+    {
+        return (current_tick & ((1ULL << bits) - 1)) == 0;
+    }
+
+    void redistribute(uint32_t &list)
+    {
+        uint32_t node = list;
+        list = NIL;
+
+        while (node != NIL) {
+            uint32_t next = nodes[node].next;
+            insert(node);
+            node = next;
+        }
+    }
+
+    double resolution;
+    uint64_t current_tick;
+
+    std::vector<Node> nodes;
+    uint32_t free_node;
+    uint32_t overflow;
+
+    // Head node of each slot, level by level.
+    std::vector<uint32_t> slots;
+};
+
+template <typename T>
+const uint32_t TimingWheel<T>::NIL;
+
+
+#endif
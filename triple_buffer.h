@@ -0,0 +1,59 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+
+// Hands values from one producer thread to one consumer thread without
+// locks or copies. The producer fills back() and publishes it; the
+// consumer acquires the latest published value and reads it through
+// front() for as long as it likes. The third slot holds the value in
+// between, so neither side ever waits for the other, and a value the
+// consumer didn't get to in time is replaced by a newer one.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back_slot {0}, front_slot {1}, middle {2} {}
+
+    // Producer side.
+    T &back() { return slots[back_slot]; }
+
+    void publish()
+    {
+        back_slot = middle.exchange(back_slot | FRESH,
+                                    std::memory_order_acq_rel) & SLOT_MASK;
+    }
+
+    // Consumer side. Switches front() to the latest published value and
+    // returns true, or returns false if nothing was published since the
+    // last call.
+    bool acquire()
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+
+        front_slot = middle.exchange(front_slot,
+                                     std::memory_order_acq_rel) & SLOT_MASK;
+        return true;
+    }
+
+    const T &front() const { return slots[front_slot]; }
+
+private:
+    static const unsigned int SLOT_MASK = 3;
+    static const unsigned int FRESH = 4;
+
+    T slots[3];
+
+    unsigned int back_slot;
+    unsigned int front_slot;
+
+    // Index of the slot in between, with FRESH set while it holds a value
+    // the consumer hasn't acquired.
+    std::atomic<unsigned int> middle;
+};
+
+
+#endif